@@ -0,0 +1,310 @@
+#include "alloc_counter.h"
+#include <SDL3/SDL_stdinc.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#include <cxxabi.h>
+#include <dlfcn.h>
+#endif
+
+// Where the current function returns to, i.e. the code that called it
+#if defined(__GNUC__) || defined(__clang__)
+#define CALLER_ADDRESS() __builtin_return_address(0)
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#define CALLER_ADDRESS() _ReturnAddress()
+#else
+#define CALLER_ADDRESS() nullptr
+#endif
+
+static std::atomic<Uint64> allocationCount{0};
+static std::atomic<Uint64> allocatedBytes{0};
+static std::atomic<Uint64> sdlAllocationCount{0};
+static std::atomic<Uint64> sdlAllocatedBytes{0};
+static thread_local Uint64 threadAllocationCount = 0;
+static thread_local Uint64 threadAllocatedBytes = 0;
+static std::atomic<bool> counting{false};   // count operator new at all
+static std::atomic<bool> tracking{false};   // also record call sites (and SDL is hooked)
+
+// Call sites: an open-addressing table keyed by the return address. A slot is
+// claimed once with a compare-and-swap and never freed, so recording needs no
+// lock and never allocates (the allocator can't call itself)
+struct AllocationSite {
+    std::atomic<uintptr_t> address;
+    std::atomic<Uint64> count;
+    std::atomic<Uint64> bytes;
+};
+static const size_t SITE_TABLE_SIZE = 4096;  // a power of two
+static AllocationSite sites[SITE_TABLE_SIZE];
+static std::atomic<Uint64> unrecordedCount{0};  // the table was full
+
+static void RecordSite(void* caller, size_t size) {
+    uintptr_t address = caller ? (uintptr_t)caller : 1;
+    size_t index = (size_t)((address * 0x9E3779B97F4A7C15ull) >> 40) & (SITE_TABLE_SIZE - 1);
+    for (size_t probe = 0; probe < SITE_TABLE_SIZE; probe++) {
+        AllocationSite& site = sites[(index + probe) & (SITE_TABLE_SIZE - 1)];
+        uintptr_t seen = site.address.load(std::memory_order_relaxed);
+        if (seen == 0 && site.address.compare_exchange_strong(seen, address, std::memory_order_relaxed)) {
+            seen = address;
+        }
+        if (seen == address) {
+            site.count.fetch_add(1, std::memory_order_relaxed);
+            site.bytes.fetch_add(size, std::memory_order_relaxed);
+            return;
+        }
+    }
+    unrecordedCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+Uint64 GetAllocationCount() {
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+Uint64 GetAllocatedBytes() {
+    return allocatedBytes.load(std::memory_order_relaxed);
+}
+
+Uint64 GetThreadAllocationCount() {
+    return threadAllocationCount;
+}
+
+Uint64 GetThreadAllocatedBytes() {
+    return threadAllocatedBytes;
+}
+
+Uint64 GetSdlAllocationCount() {
+    return sdlAllocationCount.load(std::memory_order_relaxed);
+}
+
+Uint64 GetSdlAllocatedBytes() {
+    return sdlAllocatedBytes.load(std::memory_order_relaxed);
+}
+
+static void CountAlloc(std::size_t size, void* caller) {
+    if (!counting.load(std::memory_order_relaxed)) {
+        return;
+    }
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    threadAllocationCount++;
+    threadAllocatedBytes += size;
+    if (tracking.load(std::memory_order_relaxed)) {
+        RecordSite(caller, size);
+    }
+}
+
+static void* CountedAlloc(std::size_t size, void* caller) {
+    CountAlloc(size, caller);
+    // malloc(0) may return NULL, operator new must not
+    void* memory = malloc(size == 0 ? 1 : size);
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+// Over-aligned types (alignas above the default, e.g. SpscQueue's counters)
+static void* CountedAlignedAlloc(std::size_t size, std::align_val_t alignment, void* caller) {
+    CountAlloc(size, caller);
+    std::size_t align = (std::size_t)alignment;
+#ifdef _WIN32
+    void* memory = _aligned_malloc(size == 0 ? 1 : size, align);
+#else
+    // aligned_alloc wants a multiple of the alignment
+    void* memory = aligned_alloc(align, (size + align - 1) / align * align);
+#endif
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+static void AlignedFree(void* memory) {
+#ifdef _WIN32
+    _aligned_free(memory);
+#else
+    free(memory);
+#endif
+}
+
+void* operator new(std::size_t size) {
+    return CountedAlloc(size, CALLER_ADDRESS());
+}
+
+void* operator new[](std::size_t size) {
+    return CountedAlloc(size, CALLER_ADDRESS());
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return CountedAlignedAlloc(size, alignment, CALLER_ADDRESS());
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return CountedAlignedAlloc(size, alignment, CALLER_ADDRESS());
+}
+
+void operator delete(void* memory) noexcept {
+    free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept {
+    AlignedFree(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t) noexcept {
+    AlignedFree(memory);
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept {
+    AlignedFree(memory);
+}
+
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept {
+    AlignedFree(memory);
+}
+
+// SDL's memory functions: count, then hand over to the ones SDL started with.
+// Blocks SDL allocated before tracking began go back through the same originals
+static SDL_malloc_func originalMalloc;
+static SDL_calloc_func originalCalloc;
+static SDL_realloc_func originalRealloc;
+static SDL_free_func originalFree;
+
+// Only installed by EnableAllocationTracking, which also turns counting on
+static void CountSdlAlloc(size_t size, void* caller) {
+    sdlAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    sdlAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    threadAllocationCount++;
+    threadAllocatedBytes += size;
+    RecordSite(caller, size);
+}
+
+static void* SDLCALL TrackedMalloc(size_t size) {
+    CountSdlAlloc(size, CALLER_ADDRESS());
+    return originalMalloc(size);
+}
+
+static void* SDLCALL TrackedCalloc(size_t count, size_t size) {
+    CountSdlAlloc(count * size, CALLER_ADDRESS());
+    return originalCalloc(count, size);
+}
+
+static void* SDLCALL TrackedRealloc(void* memory, size_t size) {
+    CountSdlAlloc(size, CALLER_ADDRESS());
+    return originalRealloc(memory, size);
+}
+
+static void SDLCALL TrackedFree(void* memory) {
+    originalFree(memory);
+}
+
+void EnableAllocationCounting() {
+    counting = true;
+}
+
+bool IsAllocationCountingEnabled() {
+    return counting.load(std::memory_order_relaxed);
+}
+
+bool EnableAllocationTracking() {
+    if (tracking.load()) {
+        return true;
+    }
+    counting = true;
+    SDL_GetOriginalMemoryFunctions(&originalMalloc, &originalCalloc, &originalRealloc, &originalFree);
+    if (!SDL_SetMemoryFunctions(TrackedMalloc, TrackedCalloc, TrackedRealloc, TrackedFree)) {
+        return false;
+    }
+    tracking = true;
+    return true;
+}
+
+bool IsAllocationTrackingEnabled() {
+    return tracking.load(std::memory_order_relaxed);
+}
+
+// "module+0xoffset symbol+0xoffset" where the platform can tell, else the address.
+// The module offset is what `addr2line -f -C -e <module> <offset>` takes
+static void PrintSite(FILE* out, uintptr_t address) {
+#if defined(__unix__) || defined(__APPLE__)
+    Dl_info info;
+    if (dladdr((void*)address, &info) && info.dli_fname) {
+        const char* module = strrchr(info.dli_fname, '/');
+        fprintf(out, "%s+0x%llx", module ? module + 1 : info.dli_fname,
+                (unsigned long long)(address - (uintptr_t)info.dli_fbase));
+        if (info.dli_sname) {
+            int status = 0;
+            char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+            fprintf(out, "  %s+0x%llx", status == 0 ? demangled : info.dli_sname,
+                    (unsigned long long)(address - (uintptr_t)info.dli_saddr));
+            free(demangled);
+        }
+        return;
+    }
+#endif
+    fprintf(out, "0x%llx", (unsigned long long)address);
+}
+
+void PrintAllocationSites(FILE* out, int count) {
+    // Copy the table first: printing allocates, which adds to it
+    struct Site {
+        uintptr_t address;
+        Uint64 count;
+        Uint64 bytes;
+    };
+    std::vector<Site> used;
+    for (const AllocationSite& site : sites) {
+        uintptr_t address = site.address.load(std::memory_order_relaxed);
+        if (address != 0) {
+            used.push_back({ address, site.count.load(std::memory_order_relaxed),
+                             site.bytes.load(std::memory_order_relaxed) });
+        }
+    }
+    size_t shown = std::min(used.size(), (size_t)std::max(count, 0));
+    std::partial_sort(used.begin(), used.begin() + shown, used.end(),
+                      [](const Site& a, const Site& b) { return a.count > b.count; });
+
+    fprintf(out, "Top allocation call sites (%zu seen)\n", used.size());
+    fprintf(out, "%10s %12s  %s\n", "allocs", "bytes", "caller");
+    for (size_t i = 0; i < shown; i++) {
+        fprintf(out, "%10llu %12llu  ", (unsigned long long)used[i].count, (unsigned long long)used[i].bytes);
+        PrintSite(out, used[i].address);
+        fprintf(out, "\n");
+    }
+    Uint64 unrecorded = unrecordedCount.load(std::memory_order_relaxed);
+    if (unrecorded > 0) {
+        fprintf(out, "%10llu allocations from further call sites (table full)\n", (unsigned long long)unrecorded);
+    }
+}
+
+void AllocationStats::add(Uint64 allocations, Uint64 bytesAllocated) {
+    units++;
+    count += allocations;
+    bytes += bytesAllocated;
+    maxCount = std::max(maxCount, allocations);
+    maxBytes = std::max(maxBytes, bytesAllocated);
+}
+
+void AllocationStats::print(FILE* out, const char* name) const {
+    double n = units > 0 ? (double)units : 1.0;
+    fprintf(out, "%-8s %8llu  allocs mean %8.1f max %8llu  bytes mean %10.0f max %10llu\n", name,
+            (unsigned long long)units, count / n, (unsigned long long)maxCount, bytes / n,
+            (unsigned long long)maxBytes);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <SDL3/SDL_stdinc.h>
+#include <cstdio>
+
+// Allocation counters for the performance overlay
+// alloc_counter.cpp replaces the global operator new / delete (including the
+// over-aligned versions) with versions that can count every allocation, on
+// all threads and per thread, before calling malloc. Counting is opt-in:
+// until EnableAllocationCounting() the only cost is one relaxed load of a flag
+// per allocation, and all counters stay 0.
+//
+// EnableAllocationTracking() (game2048 --alloc-report) goes further: it also
+// counts SDL's own allocations, through SDL_SetMemoryFunctions, and remembers
+// where every allocation came from (the return address of operator new or
+// SDL_malloc) in a fixed lock-free table, for PrintAllocationSites().
+
+// Number of operator new calls since counting was enabled
+Uint64 GetAllocationCount();
+
+// Bytes requested by those calls
+Uint64 GetAllocatedBytes();
+
+// The same, counting only the calling thread's allocations
+Uint64 GetThreadAllocationCount();
+Uint64 GetThreadAllocatedBytes();
+
+// SDL_malloc / SDL_calloc / SDL_realloc calls and their bytes (0 until tracking is enabled)
+Uint64 GetSdlAllocationCount();
+Uint64 GetSdlAllocatedBytes();
+
+// Count operator new calls from now on (the F3 overlay turns this on)
+void EnableAllocationCounting();
+bool IsAllocationCountingEnabled();
+
+// Count operator new and SDL's allocations and record call sites from now on.
+// Call before SDL_Init. Returns false if SDL refused the memory functions
+bool EnableAllocationTracking();
+bool IsAllocationTrackingEnabled();
+
+// Print the `count` call sites that allocated most often
+void PrintAllocationSites(FILE* out, int count);
+
+// AllocationStats - allocations attributed to one kind of work (frames, moves)
+struct AllocationStats {
+    Uint64 units = 0;       // frames or moves seen
+    Uint64 count = 0;       // allocations over all of them
+    Uint64 bytes = 0;
+    Uint64 maxCount = 0;    // most allocations in one unit
+    Uint64 maxBytes = 0;
+
+    void add(Uint64 allocations, Uint64 bytesAllocated);
+
+    // One line: "<name> <units>  allocs mean .. max ..  bytes mean .. max .."
+    void print(FILE* out, const char* name) const;
+};
@@ -0,0 +1,76 @@
+#include "animation.h"
+
+void TileAnimator::add(Kind kind, int value, int fromCell, int toCell, bool merged) {
+    if (count < MAX_ANIMATIONS) {
+        pool[count++] = Animation{ kind, value, fromCell, toCell, merged };
+    }
+}
+
+void TileAnimator::startTurn(const Grid& before, Grid::Direction dir) {
+    clear();
+
+    // Walk each row or column starting at the edge the tiles move towards.
+    // A tile merges into the previous one if it has the same value and the
+    // previous one hasn't merged yet, just like in orderTilesAndMerge
+    bool vertical = (dir == Grid::UP || dir == Grid::DOWN);
+    bool reversed = (dir == Grid::DOWN || dir == Grid::RIGHT);
+    int lines = vertical ? before.getCols() : before.getRows();
+    int length = vertical ? before.getRows() : before.getCols();
+
+    for (int line = 0; line < lines; line++) {
+        auto cellAt = [&](int i) {
+            int along = reversed ? length - 1 - i : i;
+            return vertical ? before.getIndex(along, line) : before.getIndex(line, along);
+        };
+
+        int next = 0;            // next free position along the line
+        int mergeCandidate = -1; // pool index of the last tile that may still merge
+        for (int i = 0; i < length; i++) {
+            int cell = cellAt(i);
+            int value = before.at(cell).value;
+            if (value == 0) {
+                continue;
+            }
+            if (mergeCandidate != -1 && pool[mergeCandidate].value == value) {
+                // Slide into the previous tile and pop up as the doubled value
+                int target = pool[mergeCandidate].toCell;
+                pool[mergeCandidate].merged = true;
+                add(SLIDE, value, cell, target, true);
+                add(POP, value * 2, target, target);
+                mergeCandidate = -1;
+            } else {
+                mergeCandidate = count;
+                add(SLIDE, value, cell, cellAt(next));
+                next++;
+            }
+        }
+    }
+}
+
+void TileAnimator::addSpawn(const TurnRecord& turn) {
+    if (count > 0 && turn.spawnExponent != 0) {
+        add(SPAWN, 1 << turn.spawnExponent, turn.spawnCell, turn.spawnCell);
+    }
+}
+
+void TileAnimator::clear() {
+    count = 0;
+    ticks = 0;
+    accumulator = 0.0;
+}
+
+void TileAnimator::update(double seconds) {
+    if (count == 0) {
+        return;
+    }
+    // A long stall (window dragged, debugger) finishes the animation instead
+    // of stepping through all of it
+    accumulator += std::min(seconds, 0.25);
+    while (accumulator >= TICK_SECONDS) {
+        accumulator -= TICK_SECONDS;
+        if (++ticks >= SLIDE_TICKS + POP_TICKS) {
+            clear();
+            return;
+        }
+    }
+}
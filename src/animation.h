@@ -0,0 +1,126 @@
+#pragma once
+
+#include "game.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+// TileSprite - one tile as it should be drawn right now
+struct TileSprite {
+    int value;
+    SDL_FRect rect;
+};
+
+// TileAnimator - slide, merge and spawn animations for the last played turn
+// The animation advances in fixed steps of TICK_SECONDS (update() runs as many
+// steps as the elapsed time allows) and the drawn position is interpolated
+// between the last two steps, so it looks the same at any frame rate.
+// All animation state lives in a fixed-size pool: starting a turn or drawing
+// a frame never allocates.
+// A new turn always replaces the running animation (the board jumps to the
+// end of the previous one), so the animation can never lag behind the keys.
+class TileAnimator {
+public:
+    static constexpr double TICK_SECONDS = 1.0 / 120.0;
+    static const int SLIDE_TICKS = 12;  // tiles move to their new cells
+    static const int POP_TICKS = 12;    // then merged tiles pop and the new tile grows
+    static constexpr double TURN_SECONDS = (SLIDE_TICKS + POP_TICKS) * TICK_SECONDS;
+
+    // Start animating a move. Call with the grid as it was BEFORE the move;
+    // the slides and merges are worked out the same way Grid::orderTilesAndMerge does
+    void startTurn(const Grid& before, Grid::Direction dir);
+
+    // Add the tile that was spawned after the move (from the turn's TurnRecord)
+    void addSpawn(const TurnRecord& turn);
+
+    // Stop animating; the grid is drawn as it is
+    void clear();
+
+    // Advance by the elapsed real time (in fixed steps)
+    void update(double seconds);
+
+    bool isAnimating() const { return count > 0; }
+
+    // Call add(const TileSprite&) for every tile of the current animation frame
+    template <typename AddSprite>
+    void forEachSprite(const Grid& grid, AddSprite add) const;
+
+private:
+    enum Kind {
+        SLIDE,  // a tile moving from one cell to another (or staying)
+        POP,    // the result of a merge, shown after the slide
+        SPAWN   // the new tile, growing after the slide
+    };
+
+    struct Animation {
+        Kind kind;
+        int value;
+        int fromCell;
+        int toCell;
+        bool merged;  // SLIDE only: this tile disappears into a merge at the end
+    };
+
+    void add(Kind kind, int value, int fromCell, int toCell, bool merged = false);
+
+    // Every cell slides once, half of them can merge, plus one spawn
+    static const int MAX_ANIMATIONS = GRID_ROWS * GRID_COLS * 2 + 1;
+
+    std::array<Animation, MAX_ANIMATIONS> pool = {};
+    int count = 0;
+    int ticks = 0;             // fixed steps since the turn started
+    double accumulator = 0.0;  // real time not yet used up by a step
+};
+
+// Scale a rectangle around its center
+inline SDL_FRect ScaleRect(const SDL_FRect& rect, float scale) {
+    SDL_FRect scaled;
+    scaled.w = rect.w * scale;
+    scaled.h = rect.h * scale;
+    scaled.x = rect.x + (rect.w - scaled.w) / 2.0f;
+    scaled.y = rect.y + (rect.h - scaled.h) / 2.0f;
+    return scaled;
+}
+
+template <typename AddSprite>
+void TileAnimator::forEachSprite(const Grid& grid, AddSprite add) const {
+    // Time in steps, including the part of the next step that has already passed
+    float time = (float)ticks + (float)(accumulator / TICK_SECONDS);
+    float slide = std::min(time / SLIDE_TICKS, 1.0f);
+    float pop = std::clamp((time - SLIDE_TICKS) / POP_TICKS, 0.0f, 1.0f);
+    float easedSlide = 1.0f - (1.0f - slide) * (1.0f - slide);  // ease out
+
+    float tileWidth = grid.getTileWidth();
+    float tileHeight = grid.getTileHeight();
+    for (int i = 0; i < count; i++) {
+        const Animation& animation = pool[i];
+        SDL_FRect to = grid.at(animation.toCell).getRect(tileWidth, tileHeight);
+        TileSprite sprite;
+        sprite.value = animation.value;
+        switch (animation.kind) {
+        case SLIDE: {
+            if (animation.merged && slide >= 1.0f) {
+                continue;  // replaced by the POP
+            }
+            SDL_FRect from = grid.at(animation.fromCell).getRect(tileWidth, tileHeight);
+            sprite.rect = to;
+            sprite.rect.x = from.x + (to.x - from.x) * easedSlide;
+            sprite.rect.y = from.y + (to.y - from.y) * easedSlide;
+            break;
+        }
+        case POP:
+            if (slide < 1.0f) {
+                continue;
+            }
+            // Grow a little and settle back: 1 -> 1.2 -> 1
+            sprite.rect = ScaleRect(to, 1.0f + 0.2f * (1.0f - std::abs(2.0f * pop - 1.0f)));
+            break;
+        case SPAWN:
+            if (slide < 1.0f) {
+                continue;
+            }
+            sprite.rect = ScaleRect(to, pop);
+            break;
+        }
+        add(sprite);
+    }
+}
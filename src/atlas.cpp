@@ -0,0 +1,132 @@
+#include "atlas.h"
+#include "text.h"
+#include <SDL3/SDL_log.h>
+#include <cmath>
+#include <cstdio>     // for snprintf
+
+// Tiles per atlas row
+static const int ATLAS_TILE_COLUMNS = 5;
+// Glyphs per atlas row
+static const int ATLAS_GLYPH_COLUMNS = 48;
+
+bool TextureAtlas::build(SDL_Renderer* renderer, float tileWidth, float tileHeight, float pixelScale) {
+    destroy();
+    scale = pixelScale;
+
+    // Same size as Tile::getRect, rounded up to whole pixels
+    int faceWidth = (int)ceilf(tileWidth - TILE_PADDING * 2.0f);
+    int faceHeight = (int)ceilf(tileHeight - TILE_PADDING * 2.0f);
+    glyphSize = GetScaledTextHeight();
+    int glyph = (int)ceilf(glyphSize);
+
+    int tileRows = (MAX_EXPONENT + ATLAS_TILE_COLUMNS - 1) / ATLAS_TILE_COLUMNS;
+    int glyphRows = (GLYPH_COUNT + ATLAS_GLYPH_COLUMNS - 1) / ATLAS_GLYPH_COLUMNS;
+    int width = SDL_max(ATLAS_TILE_COLUMNS * (faceWidth + 2), ATLAS_GLYPH_COLUMNS * (glyph + 2));
+    int height = tileRows * (faceHeight + 2) + glyphRows * (glyph + 2);
+
+    // The layout below is in logical pixels; the texture has `scale` times as
+    // many and the render scale maps one onto the other while drawing
+    texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+                                (int)ceilf(width * scale), (int)ceilf(height * scale));
+    if (!texture) {
+        SDL_Log("Couldn't create texture atlas, using debug text: %s", SDL_GetError());
+        return false;
+    }
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+    SDL_Texture* oldTarget = SDL_GetRenderTarget(renderer);
+    if (!SDL_SetRenderTarget(renderer, texture)) {
+        SDL_Log("Couldn't render to texture atlas, using debug text: %s", SDL_GetError());
+        destroy();
+        return false;
+    }
+    SDL_SetRenderScale(renderer, scale, scale);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+    SDL_RenderClear(renderer);
+
+    // Tile faces: background color with the number centered, and a 1px gap
+    // around each face so linear filtering doesn't bleed into the neighbours
+    for (int exponent = 1; exponent <= MAX_EXPONENT; exponent++) {
+        int slot = exponent - 1;
+        SDL_FRect rect;
+        rect.x = (float)((slot % ATLAS_TILE_COLUMNS) * (faceWidth + 2) + 1);
+        rect.y = (float)((slot / ATLAS_TILE_COLUMNS) * (faceHeight + 2) + 1);
+        rect.w = (float)faceWidth;
+        rect.h = (float)faceHeight;
+        tileRects[exponent] = rect;
+
+        Tile tile(1 << exponent);
+        Uint8 r, g, b;
+        tile.getColor(r, g, b);
+        SDL_SetRenderDrawColor(renderer, r, g, b, 255);
+        SDL_RenderFillRect(renderer, &rect);
+
+        char text[32];
+        snprintf(text, sizeof(text), "%d", tile.value);
+        float textX = rect.x + (rect.w - GetScaledTextWidth(text)) / 2.0f;
+        float textY = rect.y + (rect.h - GetScaledTextHeight()) / 2.0f;
+        tile.getTextColor(r, g, b);
+        SDL_SetRenderDrawColor(renderer, r, g, b, 255);
+        RenderScaledText(renderer, textX, textY, text);
+    }
+
+    // Font: the HUD color on a transparent background
+    float glyphTop = (float)(tileRows * (faceHeight + 2));
+    SDL_SetRenderDrawColor(renderer, 119, 110, 101, 255);  // Dark gray
+    for (int i = 0; i < GLYPH_COUNT; i++) {
+        SDL_FRect rect;
+        rect.x = (float)((i % ATLAS_GLYPH_COLUMNS) * (glyph + 2) + 1);
+        rect.y = glyphTop + (float)((i / ATLAS_GLYPH_COLUMNS) * (glyph + 2) + 1);
+        rect.w = glyphSize;
+        rect.h = glyphSize;
+        glyphRects[i] = rect;
+
+        char text[2] = { (char)(FIRST_GLYPH + i), '\0' };
+        RenderScaledText(renderer, rect.x, rect.y, text);
+    }
+
+    SDL_SetRenderScale(renderer, 1.0f, 1.0f);
+    SDL_SetRenderTarget(renderer, oldTarget);
+
+    // Source rectangles are in texture pixels
+    for (SDL_FRect& rect : tileRects) {
+        rect = { rect.x * scale, rect.y * scale, rect.w * scale, rect.h * scale };
+    }
+    for (SDL_FRect& rect : glyphRects) {
+        rect = { rect.x * scale, rect.y * scale, rect.w * scale, rect.h * scale };
+    }
+    return true;
+}
+
+void TextureAtlas::destroy() {
+    if (texture) {
+        SDL_DestroyTexture(texture);
+        texture = NULL;
+    }
+}
+
+bool TextureAtlas::addTile(FrameBuilder& frame, int value, const SDL_FRect& dst) const {
+    if (!texture || value <= 0 || (value & (value - 1)) != 0) {
+        return false;
+    }
+    int exponent = 0;
+    while ((1 << exponent) < value) {
+        exponent++;
+    }
+    if (exponent > MAX_EXPONENT) {
+        return false;
+    }
+    frame.addTexturedRect(texture, tileRects[exponent], dst);
+    return true;
+}
+
+void TextureAtlas::addText(FrameBuilder& frame, float x, float y, const char* text) const {
+    for (const char* c = text; *c; c++, x += glyphSize) {
+        int index = (unsigned char)*c - FIRST_GLYPH;
+        if (*c == ' ' || index < 0 || index >= GLYPH_COUNT) {
+            continue;
+        }
+        SDL_FRect dst = { x, y, glyphSize, glyphSize };
+        frame.addTexturedRect(texture, glyphRects[index], dst);
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <SDL3/SDL_render.h>
+#include "game.h"
+#include "frame_builder.h"
+
+// TextureAtlas - one texture holding every tile face and the HUD font
+// Built at startup (and again if the renderer loses its textures or the window's
+// scale changes):
+//   - a finished tile (background color + centered number) for 2, 4, ... 131072
+//   - the debug font's printable ASCII characters, scaled by TEXT_SCALE, in the HUD color
+// Tiles and characters are added to a FrameBuilder as textured quads, so the
+// whole board and HUD text go out in one SDL_RenderGeometry call.
+class TextureAtlas {
+public:
+    static const int MAX_EXPONENT = 17;  // 131072, the largest tile a 4x4 board can hold
+
+    // Render the atlas for tiles of the given size. pixelScale is the number of
+    // texture pixels per logical pixel, so the faces stay sharp when the window
+    // is larger than the logical size. Returns false if the renderer can't
+    // render to textures; callers then fall back to debug text
+    bool build(SDL_Renderer* renderer, float tileWidth, float tileHeight, float pixelScale = 1.0f);
+    void destroy();
+    bool isReady() const { return texture != NULL; }
+    float getScale() const { return scale; }
+
+    // Add the finished tile for a value. Returns false if the value isn't in the atlas
+    bool addTile(FrameBuilder& frame, int value, const SDL_FRect& dst) const;
+
+    // Add HUD text (same size and placement as RenderScaledText)
+    void addText(FrameBuilder& frame, float x, float y, const char* text) const;
+
+private:
+    static const int FIRST_GLYPH = 32;   // ' '
+    static const int GLYPH_COUNT = 95;   // ' ' to '~'
+
+    SDL_Texture* texture = NULL;
+    SDL_FRect tileRects[MAX_EXPONENT + 1] = {};
+    SDL_FRect glyphRects[GLYPH_COUNT] = {};
+    float glyphSize = 0.0f;   // logical size of a glyph on screen
+    float scale = 1.0f;
+};
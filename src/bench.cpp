@@ -0,0 +1,217 @@
+// game2048-bench - microbenchmarks of the game rules (Grid in game.h)
+//
+// Usage: game2048-bench [--csv] [--samples n] [--sample-ms ms] [filter]
+//
+// Every benchmark runs on three boards: "start" (a new game, two tiles),
+// "mid" (150 random turns in) and "full" (15 of 16 cells taken). A benchmark
+// is timed in --samples samples (default 31) of about --sample-ms each
+// (default 10 ms); the iteration count per sample is calibrated first. The
+// median and the median absolute deviation (MAD) of the samples are reported
+// in nanoseconds per operation, which stay put between runs where a mean
+// would follow every hiccup of the machine.
+//
+// Benchmarks that change the board (move-*, spawn) start every operation
+// from a copy of it, so they include one "copy"; subtract it to compare the
+// operation alone. Only benchmarks whose name contains the filter are run.
+// --csv prints benchmark,board,median_ns,mad_ns,samples,iterations lines.
+#include "game.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Results are added here so the compiler can't drop the work
+static volatile Uint64 sink;
+
+struct BenchBoard {
+    const char* name;
+    Grid grid;
+};
+
+// The boards every benchmark runs on, built the same way on every run
+static std::vector<BenchBoard> MakeBoards() {
+    std::vector<BenchBoard> boards;
+
+    GameContext start;
+    NewGame(start, 1);
+    boards.push_back({ "start", start.grid });
+
+    GameContext mid;
+    NewGame(mid, 2);
+    Rng moves(3);
+    for (int turn = 0; turn < 150; turn++) {
+        // A random move, or the next one that changes the board
+        int first = moves.below(4);
+        for (int i = 0; i < 4 && !PlayTurn(mid, (Grid::Direction)((first + i) % 4)); i++) {
+        }
+    }
+    boards.push_back({ "mid", mid.grid });
+
+    // Mixed values (some neighbours merge) with the last cell free
+    Grid full(GRID_ROWS, GRID_COLS, GRID_WIDTH, GRID_HEIGHT);
+    for (int i = 0; i + 1 < (int)full.size(); i++) {
+        full.at(i).value = 2 << ((i * 5) % 11);
+    }
+    boards.push_back({ "full", full });
+    return boards;
+}
+
+// Benchmark - runs `iterations` operations on a board, returns a value for the sink
+// (work is a scratch grid and rng a generator, for the benchmarks that need them)
+struct Benchmark {
+    const char* name;
+    Uint64 (*run)(const Grid& board, Grid& work, Rng& rng, int iterations);
+};
+
+template <Grid::Direction DIR>
+static Uint64 RunMove(const Grid& board, Grid& work, Rng&, int iterations) {
+    Uint64 total = 0;
+    for (int i = 0; i < iterations; i++) {
+        work = board;
+        int score = 0;
+        total += work.orderTilesAndMerge(DIR, score) ? 1 + score : 0;
+    }
+    return total;
+}
+
+static Uint64 RunFindEmpty(const Grid& board, Grid&, Rng& rng, int iterations) {
+    Uint64 total = 0;
+    for (int i = 0; i < iterations; i++) {
+        total += board.findRandomEmptyCell(rng);
+    }
+    return total;
+}
+
+static Uint64 RunSpawn(const Grid& board, Grid& work, Rng& rng, int iterations) {
+    Uint64 total = 0;
+    for (int i = 0; i < iterations; i++) {
+        work = board;
+        total += work.spawnRandomTile(rng);
+    }
+    return total;
+}
+
+static Uint64 RunNonEmpty(const Grid& board, Grid&, Rng&, int iterations) {
+    Uint64 total = 0;
+    for (int i = 0; i < iterations; i++) {
+        total += board.getNonEmptyTiles().size();
+    }
+    return total;
+}
+
+static Uint64 RunCopy(const Grid& board, Grid& work, Rng&, int iterations) {
+    Uint64 total = 0;
+    for (int i = 0; i < iterations; i++) {
+        work = board;
+        total += work.at(i & 15).value;
+    }
+    return total;
+}
+
+// Copy into a new Grid (allocates), unlike "copy" which reuses one
+static Uint64 RunCopyNew(const Grid& board, Grid&, Rng&, int iterations) {
+    Uint64 total = 0;
+    for (int i = 0; i < iterations; i++) {
+        Grid copy = board;
+        total += copy.at(i & 15).value;
+    }
+    return total;
+}
+
+static const Benchmark BENCHMARKS[] = {
+    { "move-up", RunMove<Grid::UP> },
+    { "move-down", RunMove<Grid::DOWN> },
+    { "move-left", RunMove<Grid::LEFT> },
+    { "move-right", RunMove<Grid::RIGHT> },
+    { "find-empty", RunFindEmpty },
+    { "spawn", RunSpawn },
+    { "non-empty-tiles", RunNonEmpty },
+    { "copy", RunCopy },
+    { "copy-new", RunCopyNew },
+};
+
+// Nanoseconds for `iterations` operations
+static double TimeRun(const Benchmark& bench, const Grid& board, Grid& work, Rng& rng, int iterations) {
+    auto start = std::chrono::steady_clock::now();
+    sink = sink + bench.run(board, work, rng, iterations);
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+static double Median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    size_t n = values.size();
+    return n % 2 == 1 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2.0;
+}
+
+int main(int argc, char** argv) {
+    bool csv = false;
+    int samples = 31;
+    double sampleMs = 10.0;
+    const char* filter = "";
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--csv") == 0) {
+            csv = true;
+        } else if (strcmp(argv[i], "--samples") == 0 && hasValue) {
+            samples = std::max(atoi(argv[++i]), 1);
+        } else if (strcmp(argv[i], "--sample-ms") == 0 && hasValue) {
+            sampleMs = std::max(atof(argv[++i]), 0.1);
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "Usage: %s [--csv] [--samples n] [--sample-ms ms] [filter]\n", argv[0]);
+            return 2;
+        } else {
+            filter = argv[i];
+        }
+    }
+
+#ifndef NDEBUG
+    fprintf(stderr, "warning: not an optimized build (configure with -DCMAKE_BUILD_TYPE=Release)\n");
+#endif
+
+    std::vector<BenchBoard> boards = MakeBoards();
+    Grid work(GRID_ROWS, GRID_COLS, GRID_WIDTH, GRID_HEIGHT);
+    if (csv) {
+        printf("benchmark,board,median_ns,mad_ns,samples,iterations\n");
+    } else {
+        printf("%-16s %-6s %12s %10s %8s\n", "benchmark", "board", "median ns/op", "MAD ns", "MAD %");
+    }
+    for (const Benchmark& bench : BENCHMARKS) {
+        if (!strstr(bench.name, filter)) {
+            continue;
+        }
+        for (const BenchBoard& board : boards) {
+            Rng rng(42);
+
+            // Calibrate: double the iterations until one run takes a tenth of a sample
+            int iterations = 1;
+            while (TimeRun(bench, board.grid, work, rng, iterations) < sampleMs * 1e5 && iterations < (1 << 26)) {
+                iterations *= 2;
+            }
+            iterations = std::max(1, iterations * 10);
+
+            std::vector<double> perOp(samples);
+            for (int s = 0; s < samples; s++) {
+                perOp[s] = TimeRun(bench, board.grid, work, rng, iterations) / iterations;
+            }
+            double median = Median(perOp);
+            std::vector<double> deviations(samples);
+            for (int s = 0; s < samples; s++) {
+                deviations[s] = std::abs(perOp[s] - median);
+            }
+            double mad = Median(deviations);
+
+            if (csv) {
+                printf("%s,%s,%.3f,%.3f,%d,%d\n", bench.name, board.name, median, mad, samples, iterations);
+            } else {
+                printf("%-16s %-6s %12.2f %10.2f %7.1f%%\n", bench.name, board.name, median, mad,
+                       median > 0.0 ? 100.0 * mad / median : 0.0);
+            }
+            fflush(stdout);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <SDL3/SDL_stdinc.h>  // for Uint8, Uint16, Uint32, Uint64
+#include <cstring>
+#include <vector>
+
+// Little-endian helpers so saved files are portable between machines
+
+inline void PutBytes(std::vector<Uint8>& out, const void* bytes, size_t size) {
+    size_t at = out.size();
+    out.resize(at + size);
+    memcpy(out.data() + at, bytes, size);
+}
+
+inline void PutU16(std::vector<Uint8>& out, Uint16 v) {
+    out.push_back((Uint8)(v & 0xFF));
+    out.push_back((Uint8)(v >> 8));
+}
+
+inline void PutU32(std::vector<Uint8>& out, Uint32 v) {
+    for (int i = 0; i < 4; i++) {
+        out.push_back((Uint8)(v >> (i * 8)));
+    }
+}
+
+inline void PutU64(std::vector<Uint8>& out, Uint64 v) {
+    for (int i = 0; i < 8; i++) {
+        out.push_back((Uint8)(v >> (i * 8)));
+    }
+}
+
+inline Uint64 GetLE(const Uint8* p, int bytes) {
+    Uint64 v = 0;
+    for (int i = 0; i < bytes; i++) {
+        v |= (Uint64)p[i] << (i * 8);
+    }
+    return v;
+}
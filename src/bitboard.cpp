@@ -0,0 +1,158 @@
+#include "bitboard.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+// Row evaluation weights for the solver (empty cells, merges, monotonicity)
+static const float SCORE_LOST_PENALTY = 200000.0f;
+static const float SCORE_MONOTONICITY_POWER = 4.0f;
+static const float SCORE_MONOTONICITY_WEIGHT = 47.0f;
+static const float SCORE_SUM_POWER = 3.5f;
+static const float SCORE_SUM_WEIGHT = 11.0f;
+static const float SCORE_MERGES_WEIGHT = 700.0f;
+static const float SCORE_EMPTY_WEIGHT = 270.0f;
+
+BoardTables::BoardTables() {
+    for (int row = 0; row < 65536; row++) {
+        int line[4];
+        for (int i = 0; i < 4; i++) {
+            line[i] = (row >> (4 * i)) & 0xF;
+        }
+
+        // Heuristic: reward empty cells and possible merges, punish non-monotonic rows
+        float sum = 0.0f;
+        int empty = 0;
+        int merges = 0;
+        int previous = 0;
+        int counter = 0;
+        for (int i = 0; i < 4; i++) {
+            int rank = line[i];
+            sum += powf((float)rank, SCORE_SUM_POWER);
+            if (rank == 0) {
+                empty++;
+            } else {
+                if (previous == rank) {
+                    counter++;
+                } else if (counter > 0) {
+                    merges += 1 + counter;
+                    counter = 0;
+                }
+                previous = rank;
+            }
+        }
+        if (counter > 0) {
+            merges += 1 + counter;
+        }
+        float monotonicityLeft = 0.0f;
+        float monotonicityRight = 0.0f;
+        for (int i = 1; i < 4; i++) {
+            float a = powf((float)line[i - 1], SCORE_MONOTONICITY_POWER);
+            float b = powf((float)line[i], SCORE_MONOTONICITY_POWER);
+            if (line[i - 1] > line[i]) {
+                monotonicityLeft += a - b;
+            } else {
+                monotonicityRight += b - a;
+            }
+        }
+        heuristic[row] = SCORE_LOST_PENALTY +
+            SCORE_EMPTY_WEIGHT * empty +
+            SCORE_MERGES_WEIGHT * merges -
+            SCORE_MONOTONICITY_WEIGHT * std::min(monotonicityLeft, monotonicityRight) -
+            SCORE_SUM_WEIGHT * sum;
+
+        // Move left: compact towards cell 0, merging each pair once
+        // (same rules as Grid::orderTilesAndMerge)
+        int result[4] = { 0, 0, 0, 0 };
+        int count = 0;
+        int mergeScore = 0;
+        bool canMerge = false;
+        for (int i = 0; i < 4; i++) {
+            if (line[i] == 0) {
+                continue;
+            }
+            if (canMerge && result[count - 1] == line[i] && line[i] < 15) {
+                result[count - 1]++;
+                mergeScore += 1 << result[count - 1];
+                canMerge = false;
+            } else {
+                result[count++] = line[i];
+                canMerge = true;
+            }
+        }
+        int left = result[0] | (result[1] << 4) | (result[2] << 8) | (result[3] << 12);
+        moveLeft[row] = (Uint16)left;
+        score[row] = mergeScore;
+    }
+
+    // Move right is move left on the reversed row
+    for (int row = 0; row < 65536; row++) {
+        int reversed = ((row & 0xF) << 12) | ((row & 0xF0) << 4) | ((row & 0xF00) >> 4) | ((row & 0xF000) >> 12);
+        int moved = moveLeft[reversed];
+        moveRight[row] = (Uint16)(((moved & 0xF) << 12) | ((moved & 0xF0) << 4) | ((moved & 0xF00) >> 4) | ((moved & 0xF000) >> 12));
+    }
+}
+
+const BoardTables& GetBoardTables() {
+    static const BoardTables* tables = new BoardTables();
+    return *tables;
+}
+
+bool BoardFromGrid(const Grid& grid, Board& board) {
+    if (grid.getRows() != BOARD_SIZE || grid.getCols() != BOARD_SIZE) {
+        return false;
+    }
+    board = 0;
+    int topTiles = 0;  // 32768 tiles; two of them would merge in Grid but not here
+    for (int i = 0; i < BOARD_CELLS; i++) {
+        int value = grid.at(i).value;
+        if (value == 0) {
+            continue;
+        }
+        int exponent = 0;
+        while ((1 << exponent) < value) {
+            exponent++;
+        }
+        if ((1 << exponent) != value || exponent > 15) {
+            return false;
+        }
+        if (exponent == 15 && ++topTiles > 1) {
+            return false;
+        }
+        board = BoardSetExponent(board, i, exponent);
+    }
+    return true;
+}
+
+void BoardToGrid(Board board, Grid& grid) {
+    for (int i = 0; i < BOARD_CELLS; i++) {
+        int exponent = BoardGetExponent(board, i);
+        grid.at(i).value = exponent == 0 ? 0 : 1 << exponent;
+    }
+}
+
+int BoardCountEmpty(Board board) {
+    // Fold each nibble to one bit that is set when the nibble is non-zero
+    board |= (board >> 2);
+    board |= (board >> 1);
+    board &= 0x1111111111111111ull;
+    return BOARD_CELLS - std::popcount(board);
+}
+
+Board BoardMove(Board board, Grid::Direction dir, int* score) {
+    const BoardTables& tables = GetBoardTables();
+    bool vertical = (dir == Grid::UP || dir == Grid::DOWN);
+    bool towardsStart = (dir == Grid::UP || dir == Grid::LEFT);
+
+    // Columns become rows after a transpose, so every move is a row move
+    Board source = vertical ? BoardTranspose(board) : board;
+    Board result = 0;
+    for (int row = 0; row < BOARD_SIZE; row++) {
+        int line = (int)((source >> (16 * row)) & 0xFFFF);
+        Board moved = towardsStart ? tables.moveLeft[line] : tables.moveRight[line];
+        result |= moved << (16 * row);
+        if (score) {
+            *score += tables.score[line];
+        }
+    }
+    return vertical ? BoardTranspose(result) : result;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "game.h"
+
+// Board - compact 4x4 board for the solver and other tools that play many moves
+// 16 cells x 4 bits, cell i (row-major, same as Grid::getIndex) in bits 4*i..4*i+3.
+// A cell holds the tile's exponent: 0 = empty, 1 = 2, 2 = 4, ... 15 = 32768.
+// Moves use precomputed row tables and follow the same rules as
+// Grid::orderTilesAndMerge (each tile merges at most once, nearest pair first).
+typedef Uint64 Board;
+
+const int BOARD_SIZE = 4;
+const int BOARD_CELLS = BOARD_SIZE * BOARD_SIZE;
+
+// Convert between Grid and Board. BoardFromGrid fails if the grid is not 4x4,
+// has a tile above 32768 or a value that is not a power of two, or has more
+// than one 32768 tile (see BoardMove: the two engines could play it differently)
+bool BoardFromGrid(const Grid& grid, Board& board);
+void BoardToGrid(Board board, Grid& grid);
+
+inline int BoardGetExponent(Board board, int index) {
+    return (int)((board >> (4 * index)) & 0xF);
+}
+
+inline Board BoardSetExponent(Board board, int index, int exponent) {
+    return (board & ~((Board)0xF << (4 * index))) | ((Board)exponent << (4 * index));
+}
+
+// Swap rows and columns
+inline Board BoardTranspose(Board x) {
+    Board a1 = x & 0xF0F00F0FF0F00F0Full;
+    Board a2 = x & 0x0000F0F00000F0F0ull;
+    Board a3 = x & 0x0F0F00000F0F0000ull;
+    Board a = a1 | (a2 << 12) | (a3 >> 12);
+    Board b1 = a & 0xFF00FF0000FF00FFull;
+    Board b2 = a & 0x00FF00FF00000000ull;
+    Board b3 = a & 0x00000000FF00FF00ull;
+    return b1 | (b2 >> 24) | (b3 << 24);
+}
+
+// Number of empty cells
+int BoardCountEmpty(Board board);
+
+// Move the board; returns the same board if nothing moves
+// If score is given, the merge score (sum of merged tile values) is added to it
+// Limit: a cell can't hold 65536, so two 32768 tiles never merge here while
+// Grid merges them. Boards from BoardFromGrid start with at most one 32768 tile;
+// a search that creates a second one plays on as if it could not merge.
+Board BoardMove(Board board, Grid::Direction dir, int* score = nullptr);
+
+// Tables used by BoardMove, exposed for the solver's evaluation
+struct BoardTables {
+    Uint16 moveLeft[65536];   // row after moving towards cell 0
+    Uint16 moveRight[65536];  // row after moving towards cell 3
+    int score[65536];         // merge score of moving the row (same both ways)
+    float heuristic[65536];   // solver's evaluation of a row
+
+    BoardTables();
+};
+
+// Shared tables, built on first use
+const BoardTables& GetBoardTables();
@@ -0,0 +1,253 @@
+// game2048-engine - analysis server speaking a line protocol on stdin/stdout
+//
+// Commands (one per line):
+//   position <16 tile values>     set the board, row by row, 0 = empty
+//   go [depth N] [movetime MS] [nodes N] [id TAG]
+//                                 search the board; without limits depth 3
+//   setoption threads N           worker threads (0 = one per core)
+//   setoption hash MB             transposition table size
+//   clear                         forget the transposition table
+//   bench [file] [depth N] [movetime MS] [nodes N]
+//                                 search every position of a suite (default
+//                                 positions/standard.txt, depth 4) and report
+//   isready                       answered with "readyok"
+//   quit
+//
+// Every completed search depth prints
+//   info [id TAG] depth D nodes N nps X time MS tthits PERCENT
+// and the search ends with one line per legal move, best first, then the best move:
+//   move [id TAG] <up|down|left|right> <expected value>
+//   bestmove [id TAG] <up|down|left|right|none>
+//
+// bench prints one line per position and a summary:
+//   bench <name> move <dir> ref <dir> depth D nodes N nps X tthits PERCENT ttd MS/MS/...
+//   bench positions P agree A nodes N time MS nps X tthits PERCENT score S
+// ttd is the time to reach each depth. score is the thousands of nodes per
+// second times the fraction of reference moves found, so it goes up both when
+// the search gets faster and when it picks better moves. `game2048-engine
+// bench ...` on the command line runs the same and exits.
+//
+// Requests are answered strictly in order, so clients may send many
+// position/go pairs without waiting (pipelining). The solver's thread pool
+// and transposition table stay alive between requests.
+#include "solver.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+static const char* DIRECTION_NAMES[4] = { "up", "down", "left", "right" };
+
+// " id TAG" when the request was tagged, otherwise nothing
+static std::string IdSuffix(const std::string& id) {
+    return id.empty() ? std::string() : " id " + id;
+}
+
+static void HandlePosition(std::istringstream& args, Board& board) {
+    Grid grid(GRID_ROWS, GRID_COLS, GRID_WIDTH, GRID_HEIGHT);
+    for (size_t i = 0; i < grid.size(); i++) {
+        if (!(args >> grid.at((int)i).value)) {
+            printf("error position needs %zu tile values\n", grid.size());
+            return;
+        }
+    }
+    Board parsed;
+    if (!BoardFromGrid(grid, parsed)) {
+        printf("error tiles must be 0 or powers of two up to 32768, with at most one 32768\n");
+        return;
+    }
+    board = parsed;
+}
+
+static void HandleGo(std::istringstream& args, Solver& solver, Board board) {
+    SearchLimits limits;
+    std::string id;
+    std::string word;
+    while (args >> word) {
+        if (word == "depth") {
+            args >> limits.depth;
+        } else if (word == "movetime") {
+            args >> limits.movetimeMs;
+        } else if (word == "nodes") {
+            args >> limits.nodes;
+        } else if (word == "id") {
+            args >> id;
+        }
+    }
+    std::string tag = IdSuffix(id);
+
+    SearchResult result = solver.search(board, limits, [&](const SearchResult& iteration) {
+        double hitRate = iteration.ttProbes ? 100.0 * iteration.ttHits / iteration.ttProbes : 0.0;
+        printf("info%s depth %d nodes %llu nps %.0f time %.0f tthits %.1f\n", tag.c_str(),
+               iteration.depth, (unsigned long long)iteration.nodes, iteration.nodesPerSecond(),
+               iteration.seconds * 1000.0, hitRate);
+    });
+    for (const MoveScore& move : result.moves) {
+        printf("move%s %s %.1f\n", tag.c_str(), DIRECTION_NAMES[move.dir], move.value);
+    }
+    printf("bestmove%s %s\n", tag.c_str(), result.moves.empty() ? "none" : DIRECTION_NAMES[result.moves[0].dir]);
+}
+
+// One position of a bench suite (see positions/standard.txt)
+struct BenchPosition {
+    std::string name;
+    int reference;    // Grid::Direction of the reference move
+    Board board;
+};
+
+static int ParseDirection(const std::string& name) {
+    for (int dir = 0; dir < 4; dir++) {
+        if (name == DIRECTION_NAMES[dir]) {
+            return dir;
+        }
+    }
+    return -1;
+}
+
+static bool LoadBenchSuite(const std::string& path, std::vector<BenchPosition>& positions) {
+    std::ifstream file(path);
+    if (!file) {
+        printf("error can't open %s\n", path.c_str());
+        return false;
+    }
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        std::istringstream fields(line);
+        BenchPosition position;
+        std::string move;
+        if (!(fields >> position.name) || position.name[0] == '#') {
+            continue;
+        }
+        fields >> move;
+        position.reference = ParseDirection(move);
+        Grid grid(GRID_ROWS, GRID_COLS, GRID_WIDTH, GRID_HEIGHT);
+        bool ok = position.reference >= 0;
+        for (size_t i = 0; i < grid.size() && ok; i++) {
+            ok = (bool)(fields >> grid.at((int)i).value);
+        }
+        if (!ok || !BoardFromGrid(grid, position.board)) {
+            printf("error %s:%d: expected <name> <move> <16 tile values>\n", path.c_str(), lineNumber);
+            return false;
+        }
+        positions.push_back(position);
+    }
+    return true;
+}
+
+static void HandleBench(std::istringstream& args, Solver& solver) {
+    std::string path = "positions/standard.txt";
+    SearchLimits limits;
+    std::string word;
+    while (args >> word) {
+        if (word == "depth") {
+            args >> limits.depth;
+        } else if (word == "movetime") {
+            args >> limits.movetimeMs;
+        } else if (word == "nodes") {
+            args >> limits.nodes;
+        } else {
+            path = word;
+        }
+    }
+    if (limits.depth == 0 && limits.movetimeMs == 0 && limits.nodes == 0) {
+        limits.depth = 4;
+    }
+    std::vector<BenchPosition> positions;
+    if (!LoadBenchSuite(path, positions)) {
+        return;
+    }
+
+    int agree = 0;
+    Uint64 totalNodes = 0;
+    Uint64 totalProbes = 0;
+    Uint64 totalHits = 0;
+    double totalSeconds = 0.0;
+    for (const BenchPosition& position : positions) {
+        // Every position starts from an empty table, so the order doesn't matter
+        solver.clearHash();
+        std::string depthTimes;
+        SearchResult result = solver.search(position.board, limits, [&](const SearchResult& iteration) {
+            char time[32];
+            snprintf(time, sizeof(time), "%s%.1f", depthTimes.empty() ? "" : "/", iteration.seconds * 1000.0);
+            depthTimes += time;
+        });
+        int chosen = result.moves.empty() ? -1 : result.moves[0].dir;
+        agree += chosen == position.reference ? 1 : 0;
+        totalNodes += result.nodes;
+        totalProbes += result.ttProbes;
+        totalHits += result.ttHits;
+        totalSeconds += result.seconds;
+        printf("bench %s move %s ref %s depth %d nodes %llu nps %.0f tthits %.1f ttd %s\n",
+               position.name.c_str(), chosen >= 0 ? DIRECTION_NAMES[chosen] : "none",
+               DIRECTION_NAMES[position.reference], result.depth, (unsigned long long)result.nodes,
+               result.nodesPerSecond(), result.ttProbes ? 100.0 * result.ttHits / result.ttProbes : 0.0,
+               depthTimes.c_str());
+        fflush(stdout);
+    }
+
+    double nps = totalSeconds > 0.0 ? totalNodes / totalSeconds : 0.0;
+    double score = positions.empty() ? 0.0 : nps / 1000.0 * agree / positions.size();
+    printf("bench positions %zu agree %d nodes %llu time %.0f nps %.0f tthits %.1f score %.0f\n",
+           positions.size(), agree, (unsigned long long)totalNodes, totalSeconds * 1000.0, nps,
+           totalProbes ? 100.0 * totalHits / totalProbes : 0.0, score);
+}
+
+int main(int argc, char** argv) {
+    // Do the startup work (move tables, hash table, threads) once, before the first request
+    GetBoardTables();
+    Solver solver;
+    Board board = 0;
+
+    // `game2048-engine bench ...`: run the bench and exit
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        std::string benchArgs;
+        for (int i = 2; i < argc; i++) {
+            benchArgs += std::string(argv[i]) + " ";
+        }
+        std::istringstream args(benchArgs);
+        HandleBench(args, solver);
+        return 0;
+    }
+
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        std::istringstream args(line);
+        std::string command;
+        if (!(args >> command)) {
+            continue;
+        }
+
+        if (command == "position") {
+            HandlePosition(args, board);
+        } else if (command == "go") {
+            HandleGo(args, solver, board);
+        } else if (command == "setoption") {
+            std::string name;
+            int value = 0;
+            args >> name >> value;
+            if (name == "threads") {
+                solver.setThreads(value);
+            } else if (name == "hash") {
+                solver.setHashSize(value);
+            } else {
+                printf("error unknown option %s\n", name.c_str());
+            }
+        } else if (command == "bench") {
+            HandleBench(args, solver);
+        } else if (command == "clear") {
+            solver.clearHash();
+        } else if (command == "isready") {
+            printf("readyok\n");
+        } else if (command == "quit") {
+            break;
+        } else {
+            printf("error unknown command %s\n", command.c_str());
+        }
+        fflush(stdout);
+    }
+    return 0;
+}
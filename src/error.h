@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string>
+
+// Functions that can fail return false and describe the problem in an
+// optional std::string* error. Fail() does both: `return Fail(error, "...");`
+inline bool Fail(std::string* error, const std::string& message) {
+    if (error) {
+        *error = message;
+    }
+    return false;
+}
@@ -0,0 +1,73 @@
+#include "frame_builder.h"
+
+void FrameBuilder::begin() {
+    for (size_t i = 0; i < usedBatches; i++) {
+        batches[i].vertices.clear();
+        batches[i].indices.clear();
+    }
+    usedBatches = 0;
+}
+
+FrameBuilder::Batch& FrameBuilder::batchFor(SDL_Texture* texture) {
+    for (size_t i = 0; i < usedBatches; i++) {
+        if (batches[i].texture == texture) {
+            return batches[i];
+        }
+    }
+    // Reuse a batch (and its buffers) from an earlier frame if there is one
+    if (usedBatches == batches.size()) {
+        batches.emplace_back();
+    }
+    Batch& batch = batches[usedBatches++];
+    batch.texture = texture;
+    batch.textureWidth = 1.0f;
+    batch.textureHeight = 1.0f;
+    if (texture) {
+        SDL_GetTextureSize(texture, &batch.textureWidth, &batch.textureHeight);
+    }
+    return batch;
+}
+
+void FrameBuilder::addQuad(Batch& batch, const SDL_FRect& dst, SDL_FColor color,
+                           float u0, float v0, float u1, float v1) {
+    int first = (int)batch.vertices.size();
+    batch.vertices.push_back({ { dst.x, dst.y }, color, { u0, v0 } });
+    batch.vertices.push_back({ { dst.x + dst.w, dst.y }, color, { u1, v0 } });
+    batch.vertices.push_back({ { dst.x + dst.w, dst.y + dst.h }, color, { u1, v1 } });
+    batch.vertices.push_back({ { dst.x, dst.y + dst.h }, color, { u0, v1 } });
+
+    // Two triangles: 0-1-2 and 2-3-0
+    const int corners[6] = { 0, 1, 2, 2, 3, 0 };
+    for (int corner : corners) {
+        batch.indices.push_back(first + corner);
+    }
+}
+
+void FrameBuilder::addRect(const SDL_FRect& rect, SDL_FColor color) {
+    addQuad(batchFor(NULL), rect, color, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+void FrameBuilder::addTexturedRect(SDL_Texture* texture, const SDL_FRect& src, const SDL_FRect& dst) {
+    Batch& batch = batchFor(texture);
+    float u0 = src.x / batch.textureWidth;
+    float v0 = src.y / batch.textureHeight;
+    float u1 = (src.x + src.w) / batch.textureWidth;
+    float v1 = (src.y + src.h) / batch.textureHeight;
+    addQuad(batch, dst, SDL_FColor{ 1.0f, 1.0f, 1.0f, 1.0f }, u0, v0, u1, v1);
+}
+
+void FrameBuilder::submit(SDL_Renderer* renderer) {
+    drawCalls = 0;
+    vertexCount = 0;
+    for (size_t i = 0; i < usedBatches; i++) {
+        const Batch& batch = batches[i];
+        if (batch.indices.empty()) {
+            continue;
+        }
+        SDL_RenderGeometry(renderer, batch.texture,
+                           batch.vertices.data(), (int)batch.vertices.size(),
+                           batch.indices.data(), (int)batch.indices.size());
+        drawCalls++;
+        vertexCount += (int)batch.vertices.size();
+    }
+}
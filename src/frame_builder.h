@@ -0,0 +1,51 @@
+#pragma once
+
+#include <SDL3/SDL_render.h>
+#include <vector>
+
+// Convert 0-255 color components to the float color SDL_Vertex uses
+inline SDL_FColor MakeColor(Uint8 r, Uint8 g, Uint8 b, Uint8 a = 255) {
+    return SDL_FColor{ r / 255.0f, g / 255.0f, b / 255.0f, a / 255.0f };
+}
+
+// FrameBuilder - collects every quad of a frame and submits them together
+// Quads are grouped by texture (NULL = plain color), and each group is sent
+// with a single SDL_RenderGeometry call, so the number of draw calls doesn't
+// grow with the number of tiles. Groups are drawn in the order they were
+// first used, so plain shapes added first end up below textured ones.
+// The vertex and index buffers keep their capacity from frame to frame.
+class FrameBuilder {
+public:
+    // Start a new frame
+    void begin();
+
+    // A solid rectangle
+    void addRect(const SDL_FRect& rect, SDL_FColor color);
+
+    // A rectangle cut out of a texture (src in texture pixels)
+    void addTexturedRect(SDL_Texture* texture, const SDL_FRect& src, const SDL_FRect& dst);
+
+    // Draw everything that was added
+    void submit(SDL_Renderer* renderer);
+
+    // Statistics of the last submit
+    int getDrawCalls() const { return drawCalls; }
+    int getVertexCount() const { return vertexCount; }
+
+private:
+    struct Batch {
+        SDL_Texture* texture;
+        float textureWidth;
+        float textureHeight;
+        std::vector<SDL_Vertex> vertices;
+        std::vector<int> indices;
+    };
+
+    Batch& batchFor(SDL_Texture* texture);
+    void addQuad(Batch& batch, const SDL_FRect& dst, SDL_FColor color, float u0, float v0, float u1, float v1);
+
+    std::vector<Batch> batches;
+    size_t usedBatches = 0;
+    int drawCalls = 0;
+    int vertexCount = 0;
+};
@@ -0,0 +1,80 @@
+#include "frame_pacer.h"
+#include <SDL3/SDL_log.h>
+#include <SDL3/SDL_timer.h>
+
+void FramePacer::configure(SDL_Renderer* renderer, SDL_Window* window, const PresentOptions& presentOptions) {
+    options = presentOptions;
+    if (!SDL_SetRenderVSync(renderer, options.vsync)) {
+        if (options.vsync == SDL_RENDERER_VSYNC_ADAPTIVE) {
+            SDL_Log("Adaptive vsync isn't supported, using normal vsync: %s", SDL_GetError());
+            options.vsync = 1;
+        } else {
+            SDL_Log("Couldn't set vsync to %d: %s", options.vsync, SDL_GetError());
+            options.vsync = 0;
+        }
+        SDL_SetRenderVSync(renderer, options.vsync);
+    }
+
+    // A frame cap sets the period; otherwise with vsync it is the display's refresh
+    periodNs = 0;
+    if (options.fpsCap > 0) {
+        periodNs = SDL_NS_PER_SECOND / (Uint64)options.fpsCap;
+    } else if (options.vsync != 0 && options.lateLatch) {
+        float refreshRate = 60.0f;
+        const SDL_DisplayMode* mode = SDL_GetCurrentDisplayMode(SDL_GetDisplayForWindow(window));
+        if (mode && mode->refresh_rate > 0.0f) {
+            refreshRate = mode->refresh_rate;
+        }
+        periodNs = (Uint64)(SDL_NS_PER_SECOND / refreshRate);
+    }
+    slotStartNs = 0;
+    drawEstimateNs = 0;
+}
+
+void FramePacer::waitForFrame() {
+    if (periodNs == 0 || slotStartNs == 0) {
+        return;
+    }
+    // Each frame gets one period. Normally it starts at the beginning of its
+    // slot; with late latch it starts as late as possible while still being
+    // presented by the end of the slot
+    Uint64 startNs = slotStartNs;
+    Uint64 leadNs = drawEstimateNs + LATE_LATCH_MARGIN_NS;
+    if (options.lateLatch && leadNs < periodNs) {
+        startNs = slotStartNs + periodNs - leadNs;
+    }
+    Uint64 now = SDL_GetTicksNS();
+    if (startNs > now) {
+        SDL_DelayPrecise(startNs - now);
+    }
+}
+
+void FramePacer::beginDraw() {
+    drawStartNs = SDL_GetTicksNS();
+}
+
+void FramePacer::beginPresent() {
+    // Follow slower frames right away and faster ones slowly, so one quick
+    // frame doesn't make the next one late
+    Uint64 drawNs = SDL_GetTicksNS() - drawStartNs;
+    if (drawNs > drawEstimateNs) {
+        drawEstimateNs = drawNs;
+    } else {
+        drawEstimateNs = (drawEstimateNs * 7 + drawNs) / 8;
+    }
+}
+
+void FramePacer::endPresent() {
+    if (periodNs == 0) {
+        return;
+    }
+    if (options.fpsCap == 0) {
+        // vsync: SDL_RenderPresent returned at a vblank, which starts the next slot
+        slotStartNs = SDL_GetTicksNS();
+    } else if (slotStartNs == 0 || drawStartNs >= slotStartNs + periodNs) {
+        // First frame, or fell behind (or was idle): start a new schedule
+        slotStartNs = drawStartNs + periodNs;
+    } else {
+        slotStartNs += periodNs;
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <SDL3/SDL_render.h>
+#include <SDL3/SDL_video.h>
+
+// PresentOptions - how frames are paced and presented (set from the command line)
+struct PresentOptions {
+    int vsync = 1;           // 0 = off, 1 = on, SDL_RENDERER_VSYNC_ADAPTIVE = adaptive
+    int fpsCap = 0;          // at most this many frames per second, 0 = no cap
+    bool lateLatch = false;  // read input as late as possible before each frame
+};
+
+// FramePacer - decides when the next frame is drawn
+// All timing uses SDL_GetTicksNS. With a frame cap, frames start at most
+// fpsCap times per second. In late-latch mode the pacer waits until just
+// before the frame is due (the next vblank with vsync, or the cap deadline),
+// so the caller can read input and draw at the last moment: key presses
+// that arrive while waiting still make it into the frame.
+// The time a frame takes to draw is measured and used as the safety margin.
+class FramePacer {
+public:
+    // Apply the vsync mode to the renderer and work out the frame period.
+    // Adaptive vsync falls back to normal vsync if the renderer can't do it
+    void configure(SDL_Renderer* renderer, SDL_Window* window, const PresentOptions& options);
+
+    // Sleep until it is time to draw the next frame (no-op without a cap or late latch)
+    void waitForFrame();
+
+    // Call when drawing starts, right before SDL_RenderPresent and right after it
+    // (the draw time excludes waiting for vsync inside SDL_RenderPresent)
+    void beginDraw();
+    void beginPresent();
+    void endPresent();
+
+    bool isLateLatch() const { return options.lateLatch && periodNs > 0; }
+
+private:
+    static const Uint64 LATE_LATCH_MARGIN_NS = 1000000;  // 1 ms of slack for the OS scheduler
+
+    PresentOptions options;
+    Uint64 periodNs = 0;        // time between frames, 0 = not paced
+    Uint64 slotStartNs = 0;     // start of the next frame's time slot, 0 = not known yet
+    Uint64 drawEstimateNs = 0;  // how long drawing a frame takes
+    Uint64 drawStartNs = 0;
+};
@@ -0,0 +1,527 @@
+#pragma once
+
+#include <SDL3/SDL_stdinc.h>  // for Uint8, Uint16, Uint64
+#include <SDL3/SDL_rect.h>    // for SDL_FRect
+#include <utility>
+#include <vector>
+#include <algorithm>  // for std::count_if, std::reverse
+#include "trace.h"
+
+// GRID CONSTANTS
+const int GRID_WIDTH = 800;
+const int GRID_HEIGHT = 800;
+const int GRID_COLS = 4;
+const int GRID_ROWS = 4;
+const float TILE_PADDING = 5.0f;
+
+// Rng - small deterministic random number generator (splitmix64)
+// Replaces rand() so that a whole game can be reproduced from its seed
+struct Rng {
+    Uint64 state;
+
+    explicit Rng(Uint64 seed = 0) : state(seed) {}
+
+    Uint64 next() {
+        Uint64 z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // Random integer in [0, n)
+    int below(int n) {
+        return (int)(next() % (Uint64)n);
+    }
+};
+
+// Tile class - represents a single tile on the grid
+class Tile {
+public:
+    int value;  // 0 means empty, otherwise the tile's number (2, 4, 8, etc.)
+    int row;
+    int col;
+
+    // Constructor - initializes a tile at a position with a value
+    Tile(int val = 0, int r = 0, int c = 0) : value(val), row(r), col(c) {}
+
+    // Check if this tile is empty
+    bool isEmpty() const { return value == 0; }
+
+    // Get the color for this tile's value
+    void getColor(Uint8& r, Uint8& g, Uint8& b) const {
+        // Default empty tile color
+        r = 205; g = 193; b = 180;
+
+        if (value == 0) {
+            r = 187; g = 173; b = 160;  // Empty cell
+        } else if (value == 2) {
+            r = 238; g = 228; b = 218;  // Light beige
+        } else if (value == 4) {
+            r = 237; g = 224; b = 200;  // Slightly darker beige
+        } else if (value == 8) {
+            r = 242; g = 177; b = 121;  // Orange
+        } else if (value == 16) {
+            r = 245; g = 149; b = 99;   // Darker orange
+        } else if (value == 32) {
+            r = 246; g = 124; b = 95;   // Red-orange
+        } else if (value == 64) {
+            r = 246; g = 94; b = 59;    // Red
+        } else if (value >= 128) {
+            r = 237; g = 204; b = 97;   // Yellow for higher values
+        }
+    }
+
+    // Get the color for this tile's number - dark for light tiles, light for dark tiles
+    void getTextColor(Uint8& r, Uint8& g, Uint8& b) const {
+        if (value <= 4) {
+            r = 119; g = 110; b = 101;  // Dark gray
+        } else {
+            r = 249; g = 246; b = 242;  // Light beige
+        }
+    }
+
+    // Get the rectangle for drawing this tile
+    SDL_FRect getRect(float tileWidth, float tileHeight) const {
+        SDL_FRect rect;
+        rect.x = (float)(col * tileWidth) + TILE_PADDING;
+        rect.y = (float)(row * tileHeight) + TILE_PADDING;
+        rect.w = tileWidth - (TILE_PADDING * 2.0f);
+        rect.h = tileHeight - (TILE_PADDING * 2.0f);
+        return rect;
+    }
+};
+
+// Grid class - manages the 4x4 game grid
+class Grid {
+private:
+    std::vector<Tile> tiles;
+    int rows;
+    int cols;
+    float width;
+    float height;
+    float tileWidth;
+    float tileHeight;
+
+public:
+    // Constructor - creates a grid with specified dimensions
+    Grid(int r, int c, float w, float h)
+        : rows(r), cols(c), width(w), height(h) {
+        tileWidth = width / cols;
+        tileHeight = height / rows;
+
+        // Initialize all tiles as empty
+        tiles.reserve(rows * cols);
+        for (int row = 0; row < rows; row++) {
+            for (int col = 0; col < cols; col++) {
+                tiles.emplace_back(0, row, col);
+            }
+        }
+    }
+
+    // Get the grid rectangle for drawing the background
+    SDL_FRect getRect() const {
+        SDL_FRect rect;
+        rect.x = 0.0f;
+        rect.y = 0.0f;
+        rect.w = width;
+        rect.h = height;
+        return rect;
+    }
+
+    // Get tile width and height
+    float getTileWidth() const { return tileWidth; }
+    float getTileHeight() const { return tileHeight; }
+
+    // Get grid dimensions in cells
+    int getRows() const { return rows; }
+    int getCols() const { return cols; }
+
+    // Convert 2D coordinates to 1D index
+    int getIndex(int row, int col) const {
+        return row * cols + col;
+    }
+
+    // Get tile at position (row, col)
+    Tile& at(int row, int col) {
+        return tiles[getIndex(row, col)];
+    }
+
+    const Tile& at(int row, int col) const {
+        return tiles[getIndex(row, col)];
+    }
+
+    // Get tile by index
+    Tile& at(int index) {
+        return tiles[index];
+    }
+
+    const Tile& at(int index) const {
+        return tiles[index];
+    }
+
+    // Get total number of cells
+    size_t size() const {
+        return tiles.size();
+    }
+
+    // Find a random empty cell index
+    // Returns -1 if no empty cells found
+    int findRandomEmptyCell(Rng& rng) const {
+        // Count empty cells using std::count_if
+        int emptyCount = (int)std::count_if(tiles.begin(), tiles.end(),
+            [](const Tile& tile) { return tile.isEmpty(); });
+
+        if (emptyCount == 0) {
+            return -1;
+        }
+
+        // Pick a random empty cell
+        int targetIndex = rng.below(emptyCount);
+        int currentIndex = 0;
+
+        // Find the targetIndex-th empty cell
+        for (size_t i = 0; i < tiles.size(); i++) {
+            if (tiles[i].isEmpty()) {
+                if (currentIndex == targetIndex) {
+                    return (int)i;
+                }
+                currentIndex++;
+            }
+        }
+
+        std::unreachable();
+    }
+
+    // Spawn a tile at a random empty position
+    // Returns the index of the new tile, or -1 if the grid is full
+    int spawnRandomTile(Rng& rng, int value = 2) {
+        int index = findRandomEmptyCell(rng);
+        if (index != -1) {
+            tiles[index].value = value;
+        }
+        return index;
+    }
+
+    // Restart the grid - clear all tiles
+    void restart() {
+        for (Tile& tile : tiles) {
+            tile.value = 0;
+        }
+    }
+
+    // Direction enum for tile movement
+    enum Direction {
+        UP,
+        DOWN,
+        LEFT,
+        RIGHT
+    };
+
+    // Move and merge tiles in the specified direction
+    // Returns true if any tiles moved or merged, false otherwise
+    // mergeScore is updated with the total value of merged tiles
+    bool orderTilesAndMerge(Direction dir, int& mergeScore) {
+        TRACE_SCOPE("Grid::orderTilesAndMerge");
+        mergeScore = 0;
+
+        // Save original state to compare later
+        std::vector<Tile> originalTiles = tiles;
+        std::vector<Tile> newTiles = tiles;
+        bool anyChange = false;
+
+        // Process each row or column depending on direction
+        if (dir == UP || dir == DOWN) {
+            // Process each column
+            for (int col = 0; col < cols; col++) {
+                // Collect non-empty tiles with their original row positions
+                std::vector<std::pair<int, int>> columnTiles; // (row, value)
+                for (int row = 0; row < rows; row++) {
+                    int idx = getIndex(row, col);
+                    if (!originalTiles[idx].isEmpty()) {
+                        columnTiles.push_back({row, originalTiles[idx].value});
+                    }
+                }
+
+                if (columnTiles.empty()) continue;
+
+                // For DOWN, we need to process from bottom to top for merging
+                // So we reverse the order, merge, then reverse back
+                std::vector<std::pair<int, int>> workingTiles = columnTiles;
+                bool wasReversed = false;
+                if (dir == DOWN) {
+                    std::reverse(workingTiles.begin(), workingTiles.end());
+                    wasReversed = true;
+                }
+
+                // Merge adjacent tiles with same value
+                std::vector<int> mergedValues; // Just the values after merging
+                for (size_t i = 0; i < workingTiles.size(); i++) {
+                    if (i < workingTiles.size() - 1 &&
+                        workingTiles[i].second == workingTiles[i + 1].second) {
+                        // Merge tiles
+                        int mergedValue = workingTiles[i].second * 2;
+                        mergedValues.push_back(mergedValue);
+                        mergeScore += mergedValue;
+                        i++; // Skip next tile as it's been merged
+                    } else {
+                        // Keep tile as is
+                        mergedValues.push_back(workingTiles[i].second);
+                    }
+                }
+
+                // Reverse back to get correct order for placement
+                if (wasReversed) {
+                    std::reverse(mergedValues.begin(), mergedValues.end());
+                }
+
+                // Check if this column actually needs to change
+                // Build what the final column should look like
+                std::vector<int> finalColumn(rows, 0);
+                for (size_t i = 0; i < mergedValues.size(); i++) {
+                    int finalRow;
+                    size_t valueIndex;
+                    if (dir == UP) {
+                        finalRow = (int)i;  // Place from top (0, 1, 2, ...)
+                        valueIndex = i;
+                    } else { // DOWN
+                        finalRow = rows - 1 - (int)i;  // Place from bottom (3, 2, 1, ...)
+                        valueIndex = mergedValues.size() - 1 - i;  // Reverse order for values
+                    }
+                    finalColumn[finalRow] = mergedValues[valueIndex];
+                }
+
+                // Compare with original column - check if anything actually changed
+                bool columnChanged = false;
+                for (int row = 0; row < rows; row++) {
+                    int idx = getIndex(row, col);
+                    if (finalColumn[row] != originalTiles[idx].value) {
+                        columnChanged = true;
+                        break;
+                    }
+                }
+
+                // Only modify this column if it changed
+                if (columnChanged) {
+                    anyChange = true;
+                    // Clear this column first
+                    for (int row = 0; row < rows; row++) {
+                        int idx = getIndex(row, col);
+                        newTiles[idx].value = 0;
+                    }
+
+                    // Place merged tiles at the edge (top for UP, bottom for DOWN)
+                    for (size_t i = 0; i < mergedValues.size(); i++) {
+                        int finalRow;
+                        size_t valueIndex;
+                        if (dir == UP) {
+                            finalRow = (int)i;  // Place from top (0, 1, 2, ...)
+                            valueIndex = i;
+                        } else { // DOWN
+                            finalRow = rows - 1 - (int)i;  // Place from bottom (3, 2, 1, ...)
+                            valueIndex = mergedValues.size() - 1 - i;  // Reverse order for values
+                        }
+                        int targetIdx = getIndex(finalRow, col);
+                        newTiles[targetIdx].value = mergedValues[valueIndex];
+                        newTiles[targetIdx].row = finalRow;
+                        newTiles[targetIdx].col = col;
+                    }
+                }
+                // If column didn't change, leave newTiles[col] as is (already copied from original)
+            }
+        } else { // LEFT or RIGHT
+            // Process each row
+            for (int row = 0; row < rows; row++) {
+                // Collect non-empty tiles with their original column positions
+                std::vector<std::pair<int, int>> rowTiles; // (col, value)
+                for (int col = 0; col < cols; col++) {
+                    int idx = getIndex(row, col);
+                    if (!originalTiles[idx].isEmpty()) {
+                        rowTiles.push_back({col, originalTiles[idx].value});
+                    }
+                }
+
+                if (rowTiles.empty()) continue;
+
+                // For RIGHT, we need to process from right to left for merging
+                // So we reverse the order, merge, then reverse back
+                std::vector<std::pair<int, int>> workingTiles = rowTiles;
+                bool wasReversed = false;
+                if (dir == RIGHT) {
+                    std::reverse(workingTiles.begin(), workingTiles.end());
+                    wasReversed = true;
+                }
+
+                // Merge adjacent tiles with same value
+                std::vector<int> mergedValues; // Just the values after merging
+                for (size_t i = 0; i < workingTiles.size(); i++) {
+                    if (i < workingTiles.size() - 1 &&
+                        workingTiles[i].second == workingTiles[i + 1].second) {
+                        // Merge tiles
+                        int mergedValue = workingTiles[i].second * 2;
+                        mergedValues.push_back(mergedValue);
+                        mergeScore += mergedValue;
+                        i++; // Skip next tile as it's been merged
+                    } else {
+                        // Keep tile as is
+                        mergedValues.push_back(workingTiles[i].second);
+                    }
+                }
+
+                // Reverse back to get correct order for placement
+                if (wasReversed) {
+                    std::reverse(mergedValues.begin(), mergedValues.end());
+                }
+
+                // Check if this row actually needs to change
+                // Build what the final row should look like
+                std::vector<int> finalRow(cols, 0);
+                for (size_t i = 0; i < mergedValues.size(); i++) {
+                    int finalCol;
+                    size_t valueIndex;
+                    if (dir == LEFT) {
+                        finalCol = (int)i;  // Place from left (0, 1, 2, ...)
+                        valueIndex = i;
+                    } else { // RIGHT
+                        finalCol = cols - 1 - (int)i;  // Place from right (3, 2, 1, ...)
+                        valueIndex = mergedValues.size() - 1 - i;  // Reverse order for values
+                    }
+                    finalRow[finalCol] = mergedValues[valueIndex];
+                }
+
+                // Compare with original row - check if anything actually changed
+                bool rowChanged = false;
+                for (int col = 0; col < cols; col++) {
+                    int idx = getIndex(row, col);
+                    if (finalRow[col] != originalTiles[idx].value) {
+                        rowChanged = true;
+                        break;
+                    }
+                }
+
+                // Only modify this row if it changed
+                if (rowChanged) {
+                    anyChange = true;
+                    // Clear this row first
+                    for (int col = 0; col < cols; col++) {
+                        int idx = getIndex(row, col);
+                        newTiles[idx].value = 0;
+                    }
+
+                    // Place merged tiles at the edge (left for LEFT, right for RIGHT)
+                    for (size_t i = 0; i < mergedValues.size(); i++) {
+                        int finalCol;
+                        size_t valueIndex;
+                        if (dir == LEFT) {
+                            finalCol = (int)i;  // Place from left (0, 1, 2, ...)
+                            valueIndex = i;
+                        } else { // RIGHT
+                            finalCol = cols - 1 - (int)i;  // Place from right (3, 2, 1, ...)
+                            valueIndex = mergedValues.size() - 1 - i;  // Reverse order for values
+                        }
+                        int targetIdx = getIndex(row, finalCol);
+                        newTiles[targetIdx].value = mergedValues[valueIndex];
+                        newTiles[targetIdx].row = row;
+                        newTiles[targetIdx].col = finalCol;
+                    }
+                }
+                // If row didn't change, leave newTiles[row] as is (already copied from original)
+            }
+        }
+
+        // Only update if something changed
+        if (anyChange) {
+            tiles = newTiles;
+            return true;
+        }
+
+        return false;
+    }
+
+    // Iterate over all tiles - useful for drawing
+    // This allows range-based for loops: for (const Tile& tile : grid) { ... }
+    auto begin() const { return tiles.begin(); }
+    auto end() const { return tiles.end(); }
+    auto begin() { return tiles.begin(); }
+    auto end() { return tiles.end(); }
+
+    // Get all non-empty tiles (useful for drawing only tiles that exist)
+    std::vector<const Tile*> getNonEmptyTiles() const {
+        std::vector<const Tile*> result;
+        for (const Tile& tile : tiles) {
+            if (!tile.isEmpty()) {
+                result.push_back(&tile);
+            }
+        }
+        return result;
+    }
+};
+
+// TurnRecord - one played turn in compact form (4 bytes)
+// Stores the move and where the new tile appeared, so a game can be
+// re-played without the random number generator
+struct TurnRecord {
+    Uint8 direction;      // Grid::Direction
+    Uint8 spawnExponent;  // log2 of the spawned value (1 = 2, 2 = 4), 0 = no spawn
+    Uint16 spawnCell;     // grid index of the spawned tile
+};
+
+// Check a turn read from a file before using it: a real direction and a 2, a 4
+// or no spawn (so shifting by spawnExponent is always defined)
+inline bool IsValidTurnRecord(const TurnRecord& turn) {
+    return turn.direction <= Grid::RIGHT && turn.spawnExponent <= 2;
+}
+
+// GameContext - holds game state
+struct GameContext {
+    Grid grid;
+    int score;
+    int high_score;
+    Rng rng;
+    Uint64 seed;                     // seed of the current game, for replays
+    std::vector<TurnRecord> turns;   // every turn played since the last NewGame
+
+    // Constructor - initializes the grid
+    GameContext() : grid(GRID_ROWS, GRID_COLS, GRID_WIDTH, GRID_HEIGHT),
+                    score(0), high_score(0), rng(0), seed(0) {}
+};
+
+// Start a new game from a seed: clear the grid and spawn 2 tiles (as per README)
+// The high score is kept
+inline void NewGame(GameContext& ctx, Uint64 seed) {
+    ctx.grid.restart();
+    ctx.score = 0;
+    ctx.rng = Rng(seed);
+    ctx.seed = seed;
+    ctx.turns.clear();
+    for (int i = 0; i < 2; i++) {
+        ctx.grid.spawnRandomTile(ctx.rng, 2);
+    }
+}
+
+// Play one turn: move the tiles, add the merge score and spawn a new tile
+// Returns false (and changes nothing) if no tile could move in that direction
+inline bool PlayTurn(GameContext& ctx, Grid::Direction dir) {
+    int mergeScore = 0;
+    if (!ctx.grid.orderTilesAndMerge(dir, mergeScore)) {
+        return false;
+    }
+
+    // Update score with merge points
+    ctx.score += mergeScore;
+
+    // Update high score if needed
+    if (ctx.score > ctx.high_score) {
+        ctx.high_score = ctx.score;
+    }
+
+    // Spawn a new tile (90% chance of 2, 10% chance of 4)
+    int newTileValue = (ctx.rng.below(10) == 0) ? 4 : 2;
+    int cell = ctx.grid.spawnRandomTile(ctx.rng, newTileValue);
+
+    TurnRecord turn;
+    turn.direction = (Uint8)dir;
+    turn.spawnExponent = (cell == -1) ? 0 : (Uint8)(newTileValue == 4 ? 2 : 1);
+    turn.spawnCell = (Uint16)(cell == -1 ? 0 : cell);
+    ctx.turns.push_back(turn);
+    return true;
+}
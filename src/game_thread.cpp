@@ -0,0 +1,185 @@
+#include "game_thread.h"
+#include "replay.h"
+#include "trace.h"
+#include <SDL3/SDL_events.h>
+#include <SDL3/SDL_log.h>
+#include <SDL3/SDL_timer.h>
+#include <chrono>
+#include <ctime>      // for time()
+#include <string>
+
+void GameThread::start(const char* path, Uint32 wakeEventType, Uint64 seed) {
+    recordPath = path;
+    wakeEvent = wakeEventType;
+    fixedSeed = seed;
+
+    // Continue the previous session if there is one
+    // (without the saver's queue, saving does nothing)
+    if (fixedSeed != 0) {
+        newGame();
+    } else if (!saver.init("siekwie", "2048") || !saver.load(ctx)) {
+        newGame();
+    }
+    history.reset();
+
+    // The first snapshot is ready before the thread starts
+    publish(NULL, NULL);
+    quit = false;
+    thread = std::thread([this]() { run(); });
+}
+
+void GameThread::stop() {
+    if (!thread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wake.notify_one();
+    thread.join();
+
+    saveRecording();
+    saver.shutdown();
+}
+
+bool GameThread::post(const GameCommand& command) {
+    if (!commands.push(command)) {
+        return false;
+    }
+    posted++;
+    // Taking the lock makes sure the thread is either still awake or already
+    // waiting (and gets the notification), never in between
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+    }
+    wake.notify_one();
+    return true;
+}
+
+void GameThread::waitUntilApplied(Uint64 timeoutNs) {
+    // Moves take microseconds, so just yield until the thread has caught up
+    Uint64 deadline = SDL_GetTicksNS() + timeoutNs;
+    while (applied.load(std::memory_order_acquire) < posted && SDL_GetTicksNS() < deadline) {
+        std::this_thread::yield();
+    }
+}
+
+void GameThread::run() {
+    TRACE_THREAD_NAME("game");
+    for (;;) {
+        GameCommand command;
+        while (commands.pop(command)) {
+            command.timing.dequeuedNs = SDL_GetTicksNS();
+            apply(command);
+            applied.fetch_add(1, std::memory_order_release);
+        }
+        saver.poll();
+
+        // Sleep until the next command. While a save is being written,
+        // wake up now and then to finish it
+        std::unique_lock<std::mutex> lock(mutex);
+        auto ready = [this]() { return quit || !commands.empty(); };
+        if (saver.isBusy()) {
+            wake.wait_for(lock, std::chrono::milliseconds(10), ready);
+        } else {
+            wake.wait(lock, ready);
+        }
+        if (quit && commands.empty()) {
+            return;
+        }
+    }
+}
+
+void GameThread::apply(GameCommand& command) {
+    TRACE_SCOPE("GameThread::apply");
+    bool changed = false;
+    switch (command.type) {
+    case GameCommand::MOVE: {
+        // Move, merge, update the score and spawn a new tile
+        std::array<int, GameSnapshot::CELLS> before;
+        for (size_t i = 0; i < before.size(); i++) {
+            before[i] = ctx.grid.at((int)i).value;
+        }
+        Uint64 allocations = GetThreadAllocationCount();
+        Uint64 allocatedBytes = GetThreadAllocatedBytes();
+        if (PlayTurn(ctx, command.direction)) {
+            command.timing.movedNs = SDL_GetTicksNS();
+            history.onTurnPlayed(ctx);
+            saver.save(ctx);
+            // Everything up to the snapshot counts for the move
+            command.allocations = GetThreadAllocationCount() - allocations;
+            command.allocatedBytes = GetThreadAllocatedBytes() - allocatedBytes;
+            moveAllocations.add(command.allocations, command.allocatedBytes);
+            publish(&command, &before);
+        }
+        return;
+    }
+    case GameCommand::UNDO:
+        changed = history.undo(ctx) > 0;
+        break;
+    case GameCommand::REDO:
+        changed = history.redo(ctx) > 0;
+        break;
+    case GameCommand::RESTART:
+        // Restart the game (keeps high_score), saving the finished one first
+        saveRecording();
+        newGame();
+        changed = true;
+        break;
+    }
+    if (changed) {
+        saver.save(ctx);
+        publish(NULL, NULL);
+    }
+}
+
+void GameThread::newGame() {
+    // Seed the game's random number generator with the current time
+    // The seed is stored with the game so it can be replayed later
+    Uint64 seed = fixedSeed != 0 ? fixedSeed : (Uint64)time(NULL) ^ SDL_GetPerformanceCounter();
+
+    // Clear the grid and spawn 2 initial tiles at random positions (as per README)
+    NewGame(ctx, seed);
+    history.reset();
+}
+
+void GameThread::saveRecording() {
+    if (!recordPath || ctx.turns.empty()) {
+        return;
+    }
+    std::string error;
+    if (!SaveReplay(recordPath, ReplayFromGame(ctx), &error)) {
+        SDL_Log("Couldn't save replay: %s", error.c_str());
+    }
+}
+
+void GameThread::publish(const GameCommand* move, const std::array<int, GameSnapshot::CELLS>* before) {
+    GameSnapshot& snapshot = snapshots.writeBuffer();
+    snapshot.version = ++version;
+    for (size_t i = 0; i < snapshot.values.size(); i++) {
+        snapshot.values[i] = ctx.grid.at((int)i).value;
+    }
+    snapshot.score = ctx.score;
+    snapshot.high_score = ctx.high_score;
+    snapshot.turnCount = (int)ctx.turns.size();
+    snapshot.moved = (move != NULL);
+    if (move) {
+        snapshot.direction = move->direction;
+        snapshot.turn = ctx.turns.back();
+        snapshot.before = *before;
+        snapshot.timing = move->timing;
+        snapshot.allocations = move->allocations;
+        snapshot.allocatedBytes = move->allocatedBytes;
+        snapshot.timing.publishedNs = SDL_GetTicksNS();
+    }
+    snapshots.publish();
+
+    // Wake up the main loop so it draws the new state
+    if (wakeEvent != 0) {
+        SDL_Event event;
+        SDL_zero(event);
+        event.type = wakeEvent;
+        SDL_PushEvent(&event);
+    }
+}
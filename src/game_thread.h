@@ -0,0 +1,116 @@
+#pragma once
+
+#include "alloc_counter.h"
+#include "game.h"
+#include "history.h"
+#include "latency_trace.h"
+#include "save.h"
+#include "spsc_queue.h"
+#include "triple_buffer.h"
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// GameCommand - something the player asked for, sent from SDL_AppEvent
+struct GameCommand {
+    enum Type {
+        MOVE,
+        UNDO,
+        REDO,
+        RESTART
+    };
+    Type type;
+    Grid::Direction direction;  // MOVE only
+    MoveTimestamps timing;      // sender fills in keyNs and postedNs, the game thread the rest
+    Uint64 allocations;         // MOVE: made by the game thread while applying it
+    Uint64 allocatedBytes;
+};
+
+// GameSnapshot - everything the renderer needs from the game, by value
+struct GameSnapshot {
+    static const int CELLS = GRID_ROWS * GRID_COLS;
+
+    Uint64 version;                  // increases with every published change
+    std::array<int, CELLS> values;   // tile values, grid index order
+    int score;
+    int high_score;
+    int turnCount;
+
+    // The move that led here, so the renderer can animate it
+    // (moved is false after undo, redo and restart: nothing to animate)
+    bool moved;
+    Grid::Direction direction;
+    TurnRecord turn;
+    std::array<int, CELLS> before;   // tile values before the move
+    MoveTimestamps timing;           // the move's way so far (up to publishedNs)
+    Uint64 allocations;              // allocations (and their bytes) made applying the move
+    Uint64 allocatedBytes;
+};
+
+// GameThread - runs the live game on its own thread
+// SDL_AppEvent post()s commands through a lock-free queue and the thread
+// applies them right away, whatever the renderer is doing. After every change
+// it publishes a GameSnapshot through a triple buffer, so drawing never waits
+// for a move and a slow move never holds up a frame. The thread also owns
+// the undo history and the session saver.
+class GameThread {
+public:
+    // Restore the last session (or start a new game) and start the thread
+    // recordPath: where to save finished games (--record), or NULL
+    // wakeEventType: SDL event pushed after each snapshot so the main loop
+    // wakes up even when it is waiting for events
+    // fixedSeed: if not 0, every game starts from this seed and the saved
+    // session is neither loaded nor written (repeatable runs, benchmarks)
+    void start(const char* recordPath, Uint32 wakeEventType, Uint64 fixedSeed = 0);
+
+    // Finish all queued commands, save the recording and the session, and stop
+    void stop();
+
+    bool isRunning() const { return thread.joinable(); }
+
+    // Main thread: queue a command. Returns false if the queue is full
+    bool post(const GameCommand& command);
+
+    // Main thread: true once every posted command has been applied
+    bool isCaughtUp() const { return applied.load(std::memory_order_acquire) == posted; }
+
+    // Main thread: wait (at most timeoutNs) until every posted command has been applied
+    void waitUntilApplied(Uint64 timeoutNs);
+
+    // Allocations made applying each move (every move, even those no
+    // snapshot showed). Read it after stop()
+    const AllocationStats& getMoveAllocations() const { return moveAllocations; }
+
+    // Main thread: switch to the newest snapshot. Returns false if nothing changed
+    bool takeSnapshot() { return snapshots.update(); }
+    const GameSnapshot& getSnapshot() const { return snapshots.readBuffer(); }
+
+private:
+    void run();
+    void apply(GameCommand& command);
+    void newGame();
+    void saveRecording();
+    void publish(const GameCommand* move, const std::array<int, GameSnapshot::CELLS>* before);
+
+    // Owned by the game thread while it runs
+    GameContext ctx;
+    History history;
+    SessionSaver saver;
+    const char* recordPath = NULL;
+    Uint32 wakeEvent = 0;
+    Uint64 fixedSeed = 0;
+    Uint64 version = 0;
+    AllocationStats moveAllocations;
+
+    SpscQueue<GameCommand, 64> commands;
+    Uint64 posted = 0;                 // commands posted (main thread only)
+    std::atomic<Uint64> applied{0};    // commands the game thread has finished
+    TripleBuffer<GameSnapshot> snapshots;
+
+    std::thread thread;
+    std::mutex mutex;                // only for sleeping and waking up
+    std::condition_variable wake;
+    bool quit = false;
+};
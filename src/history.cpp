@@ -0,0 +1,98 @@
+#include "history.h"
+#include <algorithm>
+
+void History::reset() {
+    redoTurns.clear();
+    newest = -1;
+    count = 0;
+}
+
+void History::addKeyframe(const GameContext& ctx) {
+    // Reuse the oldest slot once the ring is full, so no board is allocated twice
+    if ((int)keyframes.size() < MAX_KEYFRAMES) {
+        keyframes.emplace_back();
+    }
+    newest = (newest + 1) % (int)keyframes.size();
+    count = std::min(count + 1, (int)keyframes.size());
+
+    Keyframe& keyframe = keyframes[newest];
+    keyframe.turn = (int)ctx.turns.size();
+    keyframe.score = ctx.score;
+    keyframe.rngState = ctx.rng.state;
+    keyframe.values.resize(ctx.grid.size());
+    for (size_t i = 0; i < ctx.grid.size(); i++) {
+        keyframe.values[i] = ctx.grid.at((int)i).value;
+    }
+}
+
+void History::onTurnPlayed(const GameContext& ctx) {
+    // A new move replaces whatever could have been redone
+    redoTurns.clear();
+    if (ctx.turns.size() % KEYFRAME_INTERVAL == 0) {
+        addKeyframe(ctx);
+    }
+}
+
+int History::undo(GameContext& ctx, int steps) {
+    int position = (int)ctx.turns.size();
+    int target = std::max(position - steps, 0);
+    if (target == position) {
+        return 0;
+    }
+
+    // Undone turns go to the redo list (newest last undone = next to redo)
+    for (int i = position - 1; i >= target; i--) {
+        redoTurns.push_back(ctx.turns[i]);
+    }
+
+    // Keyframes after the target describe turns that are now undone
+    while (count > 0 && keyframes[newest].turn > target) {
+        newest = (newest - 1 + (int)keyframes.size()) % (int)keyframes.size();
+        count--;
+    }
+
+    // Restore the nearest keyframe, or the start of the game if none is left
+    int from = 0;
+    if (count > 0) {
+        const Keyframe& keyframe = keyframes[newest];
+        from = keyframe.turn;
+        for (size_t i = 0; i < keyframe.values.size(); i++) {
+            ctx.grid.at((int)i).value = keyframe.values[i];
+        }
+        ctx.score = keyframe.score;
+        ctx.rng.state = keyframe.rngState;
+    }
+    std::vector<TurnRecord> replay(ctx.turns.begin() + from, ctx.turns.begin() + target);
+    if (count == 0) {
+        std::vector<TurnRecord> redo;
+        redo.swap(redoTurns);
+        NewGame(ctx, ctx.seed);
+        redoTurns.swap(redo);
+    } else {
+        ctx.turns.resize(from);
+    }
+
+    // Play forward to the target; the restored RNG gives the same spawns
+    for (const TurnRecord& turn : replay) {
+        PlayTurn(ctx, (Grid::Direction)turn.direction);
+        if (ctx.turns.size() % KEYFRAME_INTERVAL == 0 &&
+            (count == 0 || keyframes[newest].turn < (int)ctx.turns.size())) {
+            addKeyframe(ctx);
+        }
+    }
+    return position - target;
+}
+
+int History::redo(GameContext& ctx, int steps) {
+    int done = 0;
+    while (done < steps && !redoTurns.empty()) {
+        TurnRecord turn = redoTurns.back();
+        redoTurns.pop_back();
+        PlayTurn(ctx, (Grid::Direction)turn.direction);
+        if (ctx.turns.size() % KEYFRAME_INTERVAL == 0) {
+            addKeyframe(ctx);
+        }
+        done++;
+    }
+    return done;
+}
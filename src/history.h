@@ -0,0 +1,51 @@
+#pragma once
+
+#include "game.h"
+#include <vector>
+
+// History - unlimited undo / redo for a GameContext
+//
+// The played turns are already kept in GameContext::turns as 4-byte records;
+// History adds a redo list of the same records and a ring buffer of full-board
+// keyframes (board, score, RNG state) taken every KEYFRAME_INTERVAL turns.
+// Undoing restores the nearest keyframe at or before the target turn and plays
+// the remaining turns forward again. When the target is older than every
+// keyframe in the ring, the game is rebuilt from its seed instead.
+//
+// Because the RNG state is restored too, redoing a turn (or playing the same
+// move again) spawns the same tile as before.
+//
+// Memory is 4 bytes per turn plus MAX_KEYFRAMES boards, however long the game.
+class History {
+public:
+    static const int KEYFRAME_INTERVAL = 64;
+    static const int MAX_KEYFRAMES = 256;
+
+    // Forget redo turns and keyframes, e.g. after NewGame or loading a session
+    void reset();
+
+    // Call after every successful PlayTurn that was not a redo
+    void onTurnPlayed(const GameContext& ctx);
+
+    bool canUndo(const GameContext& ctx) const { return !ctx.turns.empty(); }
+    bool canRedo() const { return !redoTurns.empty(); }
+
+    // Undo / redo up to `steps` turns. Return the number of turns actually moved
+    int undo(GameContext& ctx, int steps = 1);
+    int redo(GameContext& ctx, int steps = 1);
+
+private:
+    struct Keyframe {
+        int turn;
+        int score;
+        Uint64 rngState;
+        std::vector<int> values;
+    };
+
+    void addKeyframe(const GameContext& ctx);
+
+    std::vector<TurnRecord> redoTurns;  // undone turns, the next one to redo is at the back
+    std::vector<Keyframe> keyframes;    // ring buffer, allocated once up to MAX_KEYFRAMES
+    int newest = -1;                    // ring index of the newest keyframe
+    int count = 0;                      // number of valid keyframes in the ring
+};
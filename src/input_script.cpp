@@ -0,0 +1,90 @@
+#include "input_script.h"
+#include "error.h"
+#include <SDL3/SDL_keyboard.h>
+#include <SDL3/SDL_timer.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+bool InputScript::load(const char* path, std::string* error) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        return Fail(error, std::string("can't open ") + path);
+    }
+    events.clear();
+    char line[256];
+    int lineNumber = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file)) {
+        lineNumber++;
+        char first = line[strspn(line, " \t\r\n")];
+        if (first == '\0' || first == '#') {
+            continue;  // blank line or comment
+        }
+        double ms = -1.0;
+        char name[64] = "";
+        sscanf(line, "%lf %63s", &ms, name);
+
+        ScriptEvent event;
+        event.mod = SDL_KMOD_NONE;
+        const char* keyName = name;
+        if (SDL_strncasecmp(keyName, "shift+", 6) == 0) {
+            event.mod = SDL_KMOD_LSHIFT;
+            keyName += 6;
+        }
+        event.key = SDL_GetKeyFromName(keyName);
+        if (event.key == SDLK_UNKNOWN || ms < 0.0) {
+            ok = Fail(error, std::string(path) + ":" + std::to_string(lineNumber) +
+                      ": expected \"<milliseconds> <key>\"");
+            break;
+        }
+        event.timeNs = (Uint64)(ms * 1e6);
+        events.push_back(event);
+    }
+    fclose(file);
+    if (ok && events.empty()) {
+        ok = Fail(error, std::string(path) + " has no key presses");
+    }
+
+    // Play in time order even if the lines are not
+    std::stable_sort(events.begin(), events.end(),
+                     [](const ScriptEvent& a, const ScriptEvent& b) { return a.timeNs < b.timeNs; });
+    return ok;
+}
+
+void InputScript::start(double scriptSpeed) {
+    speed = scriptSpeed;
+    next = 0;
+    startNs = SDL_GetTicksNS();
+}
+
+void InputScript::push(const ScriptEvent& scripted, SDL_WindowID window) {
+    SDL_Event event;
+    SDL_zero(event);
+    event.type = SDL_EVENT_KEY_DOWN;
+    event.key.timestamp = SDL_GetTicksNS();
+    event.key.windowID = window;
+    event.key.which = KEYBOARD_ID;
+    event.key.key = scripted.key;
+    event.key.scancode = SDL_GetScancodeFromKey(scripted.key, NULL);
+    event.key.mod = scripted.mod;
+    event.key.down = true;
+    SDL_PushEvent(&event);
+}
+
+int InputScript::inject(SDL_WindowID window) {
+    if (isFinished()) {
+        return 0;
+    }
+    if (speed <= 0.0) {
+        push(events[next++], window);
+        return 1;
+    }
+    double elapsedNs = (double)(SDL_GetTicksNS() - startNs) * speed;
+    int pushed = 0;
+    while (!isFinished() && events[next].timeNs <= elapsedNs) {
+        push(events[next++], window);
+        pushed++;
+    }
+    return pushed;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <SDL3/SDL_events.h>
+#include <string>
+#include <vector>
+
+// ScriptEvent - one key press of an input script
+struct ScriptEvent {
+    Uint64 timeNs;      // when to press it, from the start of the script
+    SDL_Keycode key;
+    SDL_Keymod mod;
+};
+
+// InputScript - replays timed key presses through SDL's event queue
+// Script files have one key press per line:
+//   <milliseconds> <key>     e.g.  "0 Up", "120 Left", "500 shift+Z"
+// Key names are SDL's (SDL_GetKeyFromName: Up, Down, Left, Right, Z, Y, R, F3, ...),
+// times count from the start of the script, and lines starting with # are comments.
+// Events are queued with SDL_PushEvent and reach SDL_AppEvent exactly like
+// real key presses: after the SDL_AppIterate that pushed them has returned.
+class InputScript {
+public:
+    // Keyboard ID of the pushed key presses, so they can be told from real ones
+    static const SDL_KeyboardID KEYBOARD_ID = 0x53435054;  // 'SCPT'
+
+    // True for a key press pushed by inject()
+    static bool isScripted(const SDL_Event& event) {
+        return event.type == SDL_EVENT_KEY_DOWN && event.key.which == KEYBOARD_ID;
+    }
+
+    // Read a script file. On failure return false and describe the problem in error (if given)
+    bool load(const char* path, std::string* error = nullptr);
+
+    // Start playing. speed scales the script's times (2 = twice as fast);
+    // 0 ignores them and sends one key press per call of inject()
+    void start(double speed);
+
+    // Push the key presses that are due. Returns how many were pushed
+    int inject(SDL_WindowID window);
+
+    bool isFinished() const { return next >= events.size(); }
+    size_t getEventCount() const { return events.size(); }
+    double getSpeed() const { return speed; }
+
+private:
+    void push(const ScriptEvent& scripted, SDL_WindowID window);
+
+    std::vector<ScriptEvent> events;
+    size_t next = 0;
+    Uint64 startNs = 0;
+    double speed = 1.0;
+};
@@ -0,0 +1,86 @@
+#include "latency_trace.h"
+#include <bit>
+
+static const char* STAGE_NAMES[LatencyTrace::STAGE_COUNT] = {
+    "input", "queue", "move", "publish", "pickup", "render", "total"
+};
+
+int LatencyHistogram::bucketIndex(Uint64 ns) {
+    if (ns < SUB_BUCKETS) {
+        return (int)ns;
+    }
+    // Power of two above the sub-bucket range, then which part of it
+    int shift = std::bit_width(ns) - 1 - SUB_BUCKET_BITS;
+    int sub = (int)(ns >> shift) - SUB_BUCKETS;
+    return SUB_BUCKETS + shift * SUB_BUCKETS + sub;
+}
+
+Uint64 LatencyHistogram::bucketTop(int index) {
+    if (index < SUB_BUCKETS) {
+        return (Uint64)index;
+    }
+    int shift = (index - SUB_BUCKETS) / SUB_BUCKETS;
+    Uint64 sub = (Uint64)((index - SUB_BUCKETS) % SUB_BUCKETS + SUB_BUCKETS);
+    return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(Uint64 ns) {
+    counts[bucketIndex(ns)]++;
+    count++;
+    total += ns;
+    if (ns > max) {
+        max = ns;
+    }
+}
+
+void LatencyHistogram::clear() {
+    counts.fill(0);
+    count = 0;
+    total = 0;
+    max = 0;
+}
+
+Uint64 LatencyHistogram::getPercentile(double p) const {
+    if (count == 0) {
+        return 0;
+    }
+    // Rank of the value we want, counted from 1
+    Uint64 rank = (Uint64)(p / 100.0 * count + 0.5);
+    rank = SDL_clamp(rank, (Uint64)1, count);
+    Uint64 seen = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return SDL_min(bucketTop(i), max);
+        }
+    }
+    return max;
+}
+
+void LatencyTrace::record(const MoveTimestamps& times) {
+    // Clocks are read on different threads in order, so each stage is >= 0
+    // unless a timestamp is missing; those moves are skipped
+    const Uint64 points[] = { times.keyNs, times.postedNs, times.dequeuedNs, times.movedNs,
+                              times.publishedNs, times.pickedUpNs, times.presentedNs };
+    for (int i = 1; i < (int)SDL_arraysize(points); i++) {
+        if (points[i] < points[i - 1]) {
+            return;
+        }
+    }
+    for (int stage = INPUT; stage < TOTAL; stage++) {
+        stages[stage].record(points[stage + 1] - points[stage]);
+    }
+    stages[TOTAL].record(times.presentedNs - times.keyNs);
+}
+
+void LatencyTrace::print(FILE* out) const {
+    fprintf(out, "Key-to-present latency over %llu moves (microseconds)\n",
+            (unsigned long long)stages[TOTAL].getCount());
+    fprintf(out, "%-8s %9s %9s %9s %9s %9s %9s\n", "stage", "mean", "p50", "p90", "p99", "p99.9", "max");
+    for (int stage = 0; stage < STAGE_COUNT; stage++) {
+        const LatencyHistogram& h = stages[stage];
+        fprintf(out, "%-8s %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n", STAGE_NAMES[stage],
+                h.getMean() / 1e3, h.getPercentile(50) / 1e3, h.getPercentile(90) / 1e3,
+                h.getPercentile(99) / 1e3, h.getPercentile(99.9) / 1e3, h.getMax() / 1e3);
+    }
+}
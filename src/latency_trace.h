@@ -0,0 +1,75 @@
+#pragma once
+
+#include <SDL3/SDL_stdinc.h>
+#include <array>
+#include <cstdio>
+
+// MoveTimestamps - one move on its way from the key to the screen
+// All times are on the SDL_GetTicksNS clock (SDL event timestamps use it too)
+struct MoveTimestamps {
+    Uint64 keyNs;        // SDL saw the key (event timestamp)
+    Uint64 postedNs;     // SDL_AppEvent handed the command to the game thread
+    Uint64 dequeuedNs;   // the game thread took it from the command queue
+    Uint64 movedNs;      // tiles moved and merged, new tile spawned
+    Uint64 publishedNs;  // history and save done, snapshot published
+    Uint64 pickedUpNs;   // the main thread took the snapshot
+    Uint64 presentedNs;  // SDL_RenderPresent returned for the first frame showing it
+};
+
+// LatencyHistogram - HDR-style histogram of durations in nanoseconds
+// Values below SUB_BUCKETS are counted exactly; above, every power of two is
+// split into SUB_BUCKETS equal buckets, so any value from nanoseconds to
+// minutes is kept within 1 / SUB_BUCKETS (about 3%) in a fixed-size array.
+// Recording is a couple of shifts and an increment
+class LatencyHistogram {
+public:
+    static const int SUB_BUCKET_BITS = 5;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int BUCKETS = SUB_BUCKETS + (64 - SUB_BUCKET_BITS) * SUB_BUCKETS;
+
+    void record(Uint64 ns);
+    void clear();
+
+    Uint64 getCount() const { return count; }
+    Uint64 getMax() const { return max; }
+    double getMean() const { return count > 0 ? (double)total / count : 0.0; }
+
+    // Smallest value that p percent (0-100) of the recorded values are at or
+    // below, to the histogram's precision (the top of the bucket)
+    Uint64 getPercentile(double p) const;
+
+private:
+    static int bucketIndex(Uint64 ns);
+    static Uint64 bucketTop(int index);
+
+    std::array<Uint64, BUCKETS> counts = {};
+    Uint64 count = 0;
+    Uint64 total = 0;
+    Uint64 max = 0;
+};
+
+// LatencyTrace - per-stage histograms of the moves' key-to-present latency
+class LatencyTrace {
+public:
+    enum Stage {
+        INPUT,     // key -> SDL_AppEvent (SDL's event delivery)
+        QUEUE,     // SDL_AppEvent -> game thread (command queue, thread wake-up)
+        MOVE,      // move, merge and spawn
+        PUBLISH,   // undo history, session save, snapshot
+        PICKUP,    // snapshot waiting for the main thread
+        RENDER,    // drawing (and frame pacing) until the present returned
+        TOTAL,     // key -> present
+        STAGE_COUNT
+    };
+
+    // Add one move that has reached the screen
+    void record(const MoveTimestamps& times);
+
+    const LatencyHistogram& getStage(Stage stage) const { return stages[stage]; }
+
+    // Table of count, mean, percentiles and maximum per stage, in microseconds
+    void print(FILE* out) const;
+
+private:
+    std::array<LatencyHistogram, STAGE_COUNT> stages;
+};
@@ -1,17 +1,32 @@
 #include "SDL3/SDL_events.h"
 #include "SDL3/SDL_keycode.h"
-#include <utility>
-#include <vector>
-#include <algorithm>  // for std::find_if, std::count_if
-#include <cstdlib>   // for rand() and srand()
-#include <ctime>      // for time()
+#include <algorithm>  // for std::clamp
 #include <cstdio>     // for sprintf
-#include <cstring>    // for strlen
+#include <atomic>
+#include <cstdlib>    // for atoi
+#include <ctime>      // for time()
+#include <cstring>    // for strlen, strcmp
+#include <string>
 #define SDL_MAIN_USE_CALLBACKS 1
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_main.h>
 #include <SDL3/SDL_log.h>
 #include <SDL3/SDL_render.h>
+#include "game.h"
+#include "replay.h"
+#include "game_thread.h"
+#include "frame_pacer.h"
+#include "perf_overlay.h"
+#include "alloc_counter.h"
+#include "tournament.h"
+#include "video_writer.h"
+#include "input_script.h"
+#include "text.h"
+#include "atlas.h"
+#include "frame_builder.h"
+#include "render_layer.h"
+#include "animation.h"
+#include "trace.h"
 
 static SDL_Window *window = NULL;
 static SDL_Renderer *renderer = NULL;
@@ -19,606 +34,893 @@ static SDL_Renderer *renderer = NULL;
 const int SCREEN_WIDTH = 800;
 const int SCREEN_HEIGHT = 900;
 
-// GRID CONSTANTS
-const int GRID_WIDTH = 800;
-const int GRID_HEIGHT = 800;
-const int GRID_COLS = 4;
-const int GRID_ROWS = 4;
-const float TILE_PADDING = 5.0f;
+// ReplayState - playback controls for `game2048 --replay file`
+struct ReplayState {
+    ReplayPlayer player;
+    bool active;       // true when the app is showing a replay instead of a live game
+    bool paused;
+    bool scrubbing;    // mouse button held on the progress bar
+    double speed;      // turns per second
+    double cursor;     // fractional turn position while playing
+    Uint64 last_ns;    // time of the previous UpdateGame call
+};
+
+// Replay playback speed limits (turns per second)
+const double REPLAY_MIN_SPEED = 1.0;
+const double REPLAY_MAX_SPEED = 16384.0;
+const double REPLAY_DEFAULT_SPEED = 4.0;
+
+// Area below the grid that holds the score (cached in AppState::hud_layer)
+const SDL_FRect HUD_AREA = { 0.0f, (float)GRID_HEIGHT, (float)SCREEN_WIDTH, (float)(SCREEN_HEIGHT - GRID_HEIGHT) };
+
+// Replay progress bar, drawn below the score
+const SDL_FRect REPLAY_BAR = { 20.0f, 880.0f, 760.0f, 12.0f };
+
+// TournamentView - spectator mode for `game2048 --tournament <games>`
+struct TournamentView {
+    Tournament tournament;
+    bool active;
+    Uint64 mark_ns;        // start of the current statistics interval
+    Uint64 mark_moves;     // moves / nodes played when it started
+    Uint64 mark_nodes;
+    double moves_per_second;
+};
+
+// Tournament speed limits (moves per second per game)
+const int TOURNAMENT_MIN_SPEED = 1;
+const int TOURNAMENT_MAX_SPEED = 4096;
+
+// HudText - score strings, formatted only when the score changes
+struct HudText {
+    bool valid;
+    int score;
+    int high_score;
+    char score_text[16];
+    char high_score_text[16];
+};
+
+// SDL_AppIterate rates (SDL_HINT_MAIN_CALLBACK_RATE)
+// "0" runs as fast as possible (for playback and animations), "waitevent"
+// only wakes up for input, and a low rate keeps finishing background work
+// (session writes) while nothing is drawn
+const char* const CALLBACK_RATE_ACTIVE = "0";
+const char* const CALLBACK_RATE_IDLE = "waitevent";
+const char* const CALLBACK_RATE_BACKGROUND = "10";
+
+// Longest a late-latched frame waits for the game thread to apply fresh input
+const Uint64 LATE_LATCH_APPLY_TIMEOUT_NS = 500000;  // 0.5 ms
+
+// What the OS's key-repeat events do while a key is held (--key-repeat)
+enum KeyRepeatPolicy {
+    KEY_REPEAT_PACED,  // one move per animation, so a held key never outruns the screen (default)
+    KEY_REPEAT_OFF,    // ignored: one move per key press
+    KEY_REPEAT_ON      // every repeat event is a move
+};
+
+// Moves arriving faster than they animate play faster, doubling up to this
+const float MAX_ANIMATION_SPEED = 4.0f;
+
+// ScriptRun - `--input-script`: scripted key presses and what they cost
+// Every game of a scripted run starts from SCRIPT_SEED, so runs are repeatable
+const Uint64 SCRIPT_SEED = 2048;
+struct ScriptRun {
+    InputScript input;
+    bool active;
+    Uint64 start_ns;
+    std::atomic<Uint64> events;     // SDL_AppEvent calls while the script runs, any event type
+    std::atomic<Uint64> keys;       // scripted key presses SDL_AppEvent has handled (real ones don't count)
+    Uint64 frames;
+    LatencyHistogram frame_times;   // between back-to-back presents
+};
+
+// AppState - holds application state
+struct AppState {
+    SDL_Window *window;
+    SDL_Renderer *renderer;
+    GameContext game_ctx;     // what is on screen: the newest snapshot, or the replay position
+    Uint64 last_step;         // SDL_GetTicksNS() of the previous UpdateGame (animation clock)
+    ReplayState replay;
+    TournamentView spectator;  // many AI games at once (--tournament)
+    const char* record_path;  // where to save the played game (--record), or NULL
+    GameThread game_thread;   // plays the live game (with undo and saving); not used for replays
+    TextureAtlas atlas;       // tile faces and HUD font
+    HudText hud;
+    FrameBuilder frame;       // this frame's quads, submitted in one batch per texture
+    RenderLayer background_layer;  // background color, grid and grid lines
+    RenderLayer hud_layer;         // score and high score (HUD_AREA)
+    TileAnimator animator;    // slide / merge / spawn animation of the last turn
+    float animation_speed;    // 1 normally, higher while moves come in faster than they animate
+    int shown_turns;          // turn count of the snapshot on screen
+    KeyRepeatPolicy key_repeat;
+    Uint64 last_command_ns;   // when the last game command was posted
+    FramePacer pacer;         // vsync, frame cap and late latch
+    PerfOverlay overlay;      // F3: frame times, draw calls, allocations, move latency
+    Uint64 last_present_ns;   // when the previous frame was presented
+    Uint64 allocation_mark;   // allocations (operator new + SDL_malloc) at the previous present
+    Uint64 allocated_bytes_mark;  // and their bytes
+    AllocationStats frame_allocations;  // allocations between presents, per frame
+    bool alloc_report;        // print allocations per frame, per move and by call site on exit (--alloc-report)
+    LatencyTrace latency;     // key-to-present time of every move, per stage
+    ScriptRun script;         // benchmark driven by an input script (--input-script)
+    MoveTimestamps move_timing;  // the newest move, until it has been presented
+    bool move_on_way;         // move_timing is waiting for its first present
+    bool print_latency;       // print the latency table on exit (--latency)
+    const char* trace_path;   // write a Chrome trace here on exit (--trace, GAME2048_TRACE builds)
+    bool drew_last_iterate;   // the previous SDL_AppIterate drew a frame (no idle gap)
+    SDL_Surface* headless_surface;  // what the software renderer draws into when there is no window
+    bool needs_redraw;        // something on screen changed since the last DrawGame
+    bool window_hidden;       // hidden, minimized or occluded: nothing to draw into
+    const char* callback_rate;  // current SDL_HINT_MAIN_CALLBACK_RATE value
+};
+
+// Ask for the next SDL_AppIterate to draw a frame
+void RequestRedraw(AppState *as)
+{
+    as->needs_redraw = true;
+}
 
-// Text scaling factor - makes text 2.5x larger (8px * 2.5 = 20px)
-// Reduced from 3.0 to prevent overlap
-const float TEXT_SCALE = 2.5f;
+// True while the picture keeps changing without any input (tile animation, replay playback)
+bool IsAnimating(const AppState *as)
+{
+    const ReplayState& replay = as->replay;
+    bool scripted = as->script.active && !as->script.input.isFinished();
+    return as->animator.isAnimating() || as->spectator.active || scripted ||
+           (replay.active && !replay.paused && !replay.scrubbing);
+}
 
-// Calculate the width of text when rendered with scaling
-// This helps position text dynamically to prevent overlap
-float GetScaledTextWidth(const char* text, float scale = TEXT_SCALE) {
-    // SDL_DEBUG_TEXT_FONT_CHARACTER_SIZE is 8 pixels per character
-    // With scaling, each character is 8 * scale pixels wide
-    return (float)(strlen(text) * 8 * scale);
+// Change how often SDL calls SDL_AppIterate (only touches the hint when it changes)
+void SetCallbackRate(AppState *as, const char* rate)
+{
+    if (as->callback_rate != rate) {
+        SDL_SetHint(SDL_HINT_MAIN_CALLBACK_RATE, rate);
+        as->callback_rate = rate;
+    }
 }
 
-// Calculate the height of text when rendered with scaling
-float GetScaledTextHeight(float scale = TEXT_SCALE) {
-    // SDL_DEBUG_TEXT_FONT_CHARACTER_SIZE is 8 pixels tall
-    return 8.0f * scale;
+// Draw HUD text from the atlas, or with debug text if there is no atlas
+// HUD text never overlaps other shapes, so the fallback may draw right away
+void DrawHudText(AppState *as, float x, float y, const char* text)
+{
+    if (as->atlas.isReady()) {
+        as->atlas.addText(as->frame, x, y, text);
+    } else {
+        SDL_SetRenderDrawColor(as->renderer, 119, 110, 101, 255);  // Dark gray
+        RenderScaledText(as->renderer, x, y, text);
+    }
 }
 
-// Helper function to render scaled text
-// This temporarily scales the renderer, draws text, then restores the scale
-void RenderScaledText(SDL_Renderer* renderer, float x, float y, const char* text, float scale = TEXT_SCALE) {
-    // Save current render scale
-    float oldScaleX, oldScaleY;
-    SDL_GetRenderScale(renderer, &oldScaleX, &oldScaleY);
-    
-    // Set render scale to make text larger
-    SDL_SetRenderScale(renderer, scale, scale);
-    
-    // Adjust coordinates for scaled rendering (divide by scale)
-    float scaledX = x / scale;
-    float scaledY = y / scale;
-    
-    // Draw the text
-    SDL_RenderDebugText(renderer, scaledX, scaledY, text);
-    
-    // Restore original render scale
-    SDL_SetRenderScale(renderer, oldScaleX, oldScaleY);
+// Jump to a turn of the replay and continue playback from there
+void SeekReplay(AppState *as, int turn)
+{
+    ReplayState& replay = as->replay;
+    replay.player.seek(turn, as->game_ctx);
+    replay.cursor = replay.player.position();
 }
 
-// Tile class - represents a single tile on the grid
-class Tile {
-public:
-    int value;  // 0 means empty, otherwise the tile's number (2, 4, 8, etc.)
-    int row;
-    int col;
-    
-    // Constructor - initializes a tile at a position with a value
-    Tile(int val = 0, int r = 0, int c = 0) : value(val), row(r), col(c) {}
-    
-    // Check if this tile is empty
-    bool isEmpty() const { return value == 0; }
+// Seek to the turn under the mouse on the progress bar
+void ScrubReplay(AppState *as, float mouseX)
+{
+    float t = std::clamp((mouseX - REPLAY_BAR.x) / REPLAY_BAR.w, 0.0f, 1.0f);
+    SeekReplay(as, (int)(t * as->replay.player.length() + 0.5f));
+}
+
+// Copy snapshot tile values into the displayed grid
+void SetGridValues(Grid& grid, const std::array<int, GameSnapshot::CELLS>& values)
+{
+    for (size_t i = 0; i < values.size(); i++) {
+        grid.at((int)i).value = values[i];
+    }
+}
+
+// Show the newest state published by the game thread (if there is one),
+// animating the move that led to it
+void ApplySnapshot(AppState *as)
+{
+    if (!as->game_thread.takeSnapshot()) {
+        return;
+    }
+    const GameSnapshot& snapshot = as->game_thread.getSnapshot();
+    GameContext& ctx = as->game_ctx;
     
-    // Get the color for this tile's value
-    void getColor(Uint8& r, Uint8& g, Uint8& b) const {
-        // Default empty tile color
-        r = 205; g = 193; b = 180;
-        
-        if (value == 0) {
-            r = 187; g = 173; b = 160;  // Empty cell
-        } else if (value == 2) {
-            r = 238; g = 228; b = 218;  // Light beige
-        } else if (value == 4) {
-            r = 237; g = 224; b = 200;  // Slightly darker beige
-        } else if (value == 8) {
-            r = 242; g = 177; b = 121;  // Orange
-        } else if (value == 16) {
-            r = 245; g = 149; b = 99;   // Darker orange
-        } else if (value == 32) {
-            r = 246; g = 124; b = 95;   // Red-orange
-        } else if (value == 64) {
-            r = 246; g = 94; b = 59;    // Red
-        } else if (value >= 128) {
-            r = 237; g = 204; b = 97;   // Yellow for higher values
-        }
-    }
-    
-    // Get the rectangle for drawing this tile
-    SDL_FRect getRect(float tileWidth, float tileHeight) const {
-        SDL_FRect rect;
-        rect.x = (float)(col * tileWidth) + TILE_PADDING;
-        rect.y = (float)(row * tileHeight) + TILE_PADDING;
-        rect.w = tileWidth - (TILE_PADDING * 2.0f);
-        rect.h = tileHeight - (TILE_PADDING * 2.0f);
-        return rect;
-    }
-    
-    // Draw the tile's number text centered on the tile (scaled up)
-    void drawText(SDL_Renderer* renderer, float tileWidth, float tileHeight) const {
-        if (isEmpty()) {
-            return;  // Don't draw text for empty tiles
-        }
+    if (snapshot.moved) {
+        // Fast-forward while the player is ahead of the animation: a move that
+        // arrives before the last one finished (or several moves at once)
+        // animates faster; the next move after a pause is back at normal speed
+        bool behind = as->animator.isAnimating() || snapshot.turnCount > as->shown_turns + 1;
+        as->animation_speed = behind ? SDL_min(as->animation_speed * 2.0f, MAX_ANIMATION_SPEED) : 1.0f;
         
-        // Convert number to string
-        char text[32];
-        snprintf(text, sizeof(text), "%d", value);
+        // The animator needs the board from before the move
+        SetGridValues(ctx.grid, snapshot.before);
+        as->animator.startTurn(ctx.grid, snapshot.direction);
+        as->animator.addSpawn(snapshot.turn);
         
-        // Calculate text position (centered on tile)
-        SDL_FRect tileRect = getRect(tileWidth, tileHeight);
+        // Start the animation clock now; UpdateGame may not have run for a while
+        as->last_step = SDL_GetTicksNS();
         
-        // Calculate text dimensions using helper function
-        float textWidth = GetScaledTextWidth(text);
-        float textHeight = GetScaledTextHeight();
-        
-        // Center the text
-        float textX = tileRect.x + (tileRect.w - textWidth) / 2.0f;
-        float textY = tileRect.y + (tileRect.h - textHeight) / 2.0f;
-        
-        // Set text color - dark for light tiles, light for dark tiles
-        if (value <= 4) {
-            SDL_SetRenderDrawColor(renderer, 119, 110, 101, 255);  // Dark gray
-        } else {
-            SDL_SetRenderDrawColor(renderer, 249, 246, 242, 255);  // Light beige
-        }
-        
-        // Draw the text using scaled rendering
-        RenderScaledText(renderer, textX, textY, text);
+        // Follow the move until it is on screen (PresentFrame finishes the trace)
+        as->move_timing = snapshot.timing;
+        as->move_timing.pickedUpNs = as->last_step;
+        as->move_on_way = true;
+        as->overlay.recordMoveAllocations(snapshot.allocations, snapshot.allocatedBytes);
+    } else {
+        // Undo / redo / restart replace the board: nothing to animate
+        as->animator.clear();
     }
-};
+    SetGridValues(ctx.grid, snapshot.values);
+    as->shown_turns = snapshot.turnCount;
+    ctx.score = snapshot.score;
+    ctx.high_score = snapshot.high_score;
+    RequestRedraw(as);
+}
 
-// Grid class - manages the 4x4 game grid
-class Grid {
-private:
-    std::vector<Tile> tiles;
-    int rows;
-    int cols;
-    float width;
-    float height;
-    float tileWidth;
-    float tileHeight;
-    
-public:
-    // Constructor - creates a grid with specified dimensions
-    Grid(int r, int c, float w, float h) 
-        : rows(r), cols(c), width(w), height(h) {
-        tileWidth = width / cols;
-        tileHeight = height / rows;
-        
-        // Initialize all tiles as empty
-        tiles.reserve(rows * cols);
-        for (int row = 0; row < rows; row++) {
-            for (int col = 0; col < cols; col++) {
-                tiles.emplace_back(0, row, col);
-            }
-        }
+void UpdateGame(AppState *as)
+{
+    TRACE_SCOPE("UpdateGame");
+    // Pick up moves the game thread has applied since the last frame
+    if (as->game_thread.isRunning()) {
+        ApplySnapshot(as);
     }
     
-    // Get the grid rectangle for drawing the background
-    SDL_FRect getRect() const {
-        SDL_FRect rect;
-        rect.x = 0.0f;
-        rect.y = 0.0f;
-        rect.w = width;
-        rect.h = height;
-        return rect;
+    // Step the tile animation by the time since the last update
+    Uint64 now = SDL_GetTicksNS();
+    double stepSeconds = (double)(now - as->last_step) / 1e9;
+    as->last_step = now;
+    if (as->animator.isAnimating()) {
+        as->animator.update(stepSeconds * as->animation_speed);
+        RequestRedraw(as);  // also draws the last frame once it has finished
     }
     
-    // Get tile width and height
-    float getTileWidth() const { return tileWidth; }
-    float getTileHeight() const { return tileHeight; }
-    
-    // Convert 2D coordinates to 1D index
-    int getIndex(int row, int col) const {
-        return row * cols + col;
+    // The tournament never stops changing; update its numbers twice a second
+    TournamentView& spectator = as->spectator;
+    if (spectator.active) {
+        RequestRedraw(as);
+        double seconds = (double)(now - spectator.mark_ns) / 1e9;
+        if (seconds >= 0.5) {
+            Uint64 moves = spectator.tournament.getMovesPlayed();
+            Uint64 nodes = spectator.tournament.getNodesSearched();
+            spectator.moves_per_second = (moves - spectator.mark_moves) / seconds;
+            as->overlay.setSearchSpeed((nodes - spectator.mark_nodes) / seconds);
+            spectator.mark_ns = now;
+            spectator.mark_moves = moves;
+            spectator.mark_nodes = nodes;
+        }
     }
     
-    // Get tile at position (row, col)
-    Tile& at(int row, int col) {
-        return tiles[getIndex(row, col)];
+    ReplayState& replay = as->replay;
+    if (!replay.active) {
+        return;
     }
     
-    const Tile& at(int row, int col) const {
-        return tiles[getIndex(row, col)];
+    double elapsed = (double)(now - replay.last_ns) / 1e9;
+    replay.last_ns = now;
+    if (replay.paused || replay.scrubbing) {
+        return;
     }
     
-    // Get tile by index
-    Tile& at(int index) {
-        return tiles[index];
+    // Advance playback. At high speeds many turns pass between two frames;
+    // seek() applies them all (or jumps to a keyframe) and only the
+    // latest state is drawn
+    replay.cursor += elapsed * replay.speed;
+    int target = (int)std::min(replay.cursor, (double)replay.player.length());
+    if (target != replay.player.position()) {
+        replay.player.seek(target, as->game_ctx);
+        RequestRedraw(as);
     }
-    
-    const Tile& at(int index) const {
-        return tiles[index];
+    if (replay.player.position() >= replay.player.length()) {
+        replay.paused = true;
+        RequestRedraw(as);
     }
-    
-    // Get total number of cells
-    size_t size() const {
-        return tiles.size();
+}
+
+// Whether a key-repeat event may send another command (see KeyRepeatPolicy)
+bool AcceptKeyRepeat(const AppState *as)
+{
+    switch (as->key_repeat) {
+    case KEY_REPEAT_OFF:
+        return false;
+    case KEY_REPEAT_ON:
+        return true;
+    default:
+        return SDL_GetTicksNS() - as->last_command_ns >= (Uint64)(TileAnimator::TURN_SECONDS * 1e9);
     }
+}
+
+// Handle a key press while a replay is shown
+void HandleReplayKey(AppState *as, SDL_Keycode key)
+{
+    ReplayState& replay = as->replay;
+    int position = replay.player.position();
+    int length = replay.player.length();
     
-    // Find a random empty cell index
-    // Returns -1 if no empty cells found
-    int findRandomEmptyCell() const {
-        // Count empty cells using std::count_if
-        int emptyCount = (int)std::count_if(tiles.begin(), tiles.end(),
-            [](const Tile& tile) { return tile.isEmpty(); });
-        
-        if (emptyCount == 0) {
-            return -1;
+    switch (key) {
+    case SDLK_SPACE:
+        // Pause / resume, restarting from the beginning at the end
+        if (replay.paused && position >= length) {
+            SeekReplay(as, 0);
         }
-        
-        // Pick a random empty cell
-        int targetIndex = rand() % emptyCount;
-        int currentIndex = 0;
-        
-        // Find the targetIndex-th empty cell using std::find_if
-        for (size_t i = 0; i < tiles.size(); i++) {
-            if (tiles[i].isEmpty()) {
-                if (currentIndex == targetIndex) {
-                    return (int)i;
-                }
-                currentIndex++;
-            }
-        }
-        
-        std::unreachable();
+        replay.paused = !replay.paused;
+        replay.cursor = replay.player.position();
+        replay.last_ns = SDL_GetTicksNS();  // no frames ran while paused, don't count that time
+        break;
+    case SDLK_RIGHT:
+        replay.paused = true;
+        SeekReplay(as, position + 1);
+        break;
+    case SDLK_LEFT:
+        replay.paused = true;
+        SeekReplay(as, position - 1);
+        break;
+    case SDLK_UP:
+        replay.speed = std::min(replay.speed * 2.0, REPLAY_MAX_SPEED);
+        break;
+    case SDLK_DOWN:
+        replay.speed = std::max(replay.speed / 2.0, REPLAY_MIN_SPEED);
+        break;
+    case SDLK_PAGEUP:
+        SeekReplay(as, position + std::max(length / 10, 1));
+        break;
+    case SDLK_PAGEDOWN:
+        SeekReplay(as, position - std::max(length / 10, 1));
+        break;
+    case SDLK_HOME:
+        SeekReplay(as, 0);
+        break;
+    case SDLK_END:
+        SeekReplay(as, length);
+        break;
+    default:
+        break;
     }
+}
+
+// Draw the replay position, speed and progress bar
+void DrawReplayControls(AppState *as, float y)
+{
+    const ReplayState& replay = as->replay;
     
-    // Spawn a tile at a random empty position
-    bool spawnRandomTile(int value = 2) {
-        int index = findRandomEmptyCell();
-        if (index != -1) {
-            tiles[index].value = value;
-            return true;
-        }
-        return false;
-    }
+    char text[64];
+    snprintf(text, sizeof(text), "Turn %d/%d", replay.player.position(), replay.player.length());
+    DrawHudText(as, 420.0f, y, text);
     
-    // Restart the grid - clear all tiles
-    void restart() {
-        for (Tile& tile : tiles) {
-            tile.value = 0;
-        }
+    snprintf(text, sizeof(text), "x%g%s", replay.speed, replay.paused ? " PAUSED" : "");
+    DrawHudText(as, 420.0f, y + GetScaledTextHeight() + 10.0f, text);
+    
+    // Progress bar: track, then the played part
+    as->frame.addRect(REPLAY_BAR, MakeColor(205, 193, 180));
+    SDL_FRect played = REPLAY_BAR;
+    if (replay.player.length() > 0) {
+        played.w *= (float)replay.player.position() / (float)replay.player.length();
     }
+    as->frame.addRect(played, MakeColor(143, 122, 102));
+}
+
+// Add the background that never changes: grid rectangle and grid lines
+// (the background color itself comes from clearing the screen or the layer)
+void AddBackground(AppState *as)
+{
+    const Grid& grid = as->game_ctx.grid;
+    FrameBuilder& frame = as->frame;
     
-    // Direction enum for tile movement
-    enum Direction {
-        UP,
-        DOWN,
-        LEFT,
-        RIGHT
-    };
+    // Draw the grid background
+    frame.addRect(grid.getRect(), MakeColor(187, 173, 160));  // Dark beige
     
-    // Move and merge tiles in the specified direction
-    // Returns true if any tiles moved or merged, false otherwise
-    // mergeScore is updated with the total value of merged tiles
-    bool orderTilesAndMerge(Direction dir, int& mergeScore) {
-        mergeScore = 0;
-        
-        // Save original state to compare later
-        std::vector<Tile> originalTiles = tiles;
-        std::vector<Tile> newTiles = tiles;
-        bool anyChange = false;
-        
-        // Process each row or column depending on direction
-        if (dir == UP || dir == DOWN) {
-            // Process each column
-            for (int col = 0; col < cols; col++) {
-                // Collect non-empty tiles with their original row positions
-                std::vector<std::pair<int, int>> columnTiles; // (row, value)
-                for (int row = 0; row < rows; row++) {
-                    int idx = getIndex(row, col);
-                    if (!originalTiles[idx].isEmpty()) {
-                        columnTiles.push_back({row, originalTiles[idx].value});
-                    }
-                }
-                
-                if (columnTiles.empty()) continue;
-                
-                // For DOWN, we need to process from bottom to top for merging
-                // So we reverse the order, merge, then reverse back
-                std::vector<std::pair<int, int>> workingTiles = columnTiles;
-                bool wasReversed = false;
-                if (dir == DOWN) {
-                    std::reverse(workingTiles.begin(), workingTiles.end());
-                    wasReversed = true;
-                }
-                
-                // Merge adjacent tiles with same value
-                std::vector<int> mergedValues; // Just the values after merging
-                for (size_t i = 0; i < workingTiles.size(); i++) {
-                    if (i < workingTiles.size() - 1 && 
-                        workingTiles[i].second == workingTiles[i + 1].second) {
-                        // Merge tiles
-                        int mergedValue = workingTiles[i].second * 2;
-                        mergedValues.push_back(mergedValue);
-                        mergeScore += mergedValue;
-                        i++; // Skip next tile as it's been merged
-                    } else {
-                        // Keep tile as is
-                        mergedValues.push_back(workingTiles[i].second);
-                    }
-                }
-                
-                // Reverse back to get correct order for placement
-                if (wasReversed) {
-                    std::reverse(mergedValues.begin(), mergedValues.end());
-                }
-                
-                // Check if this column actually needs to change
-                // Build what the final column should look like
-                std::vector<int> finalColumn(rows, 0);
-                for (size_t i = 0; i < mergedValues.size(); i++) {
-                    int finalRow;
-                    if (dir == UP) {
-                        finalRow = (int)i;  // Place from top (0, 1, 2, ...)
-                    } else { // DOWN
-                        finalRow = rows - 1 - (int)i;  // Place from bottom (3, 2, 1, ...)
-                    }
-                    finalColumn[finalRow] = mergedValues[i];
-                }
-                
-                // Compare with original column - check if anything actually changed
-                bool columnChanged = false;
-                for (int row = 0; row < rows; row++) {
-                    int idx = getIndex(row, col);
-                    if (finalColumn[row] != originalTiles[idx].value) {
-                        columnChanged = true;
-                        break;
-                    }
-                }
-                
-                // Only modify this column if it changed
-                if (columnChanged) {
-                    anyChange = true;
-                    // Clear this column first
-                    for (int row = 0; row < rows; row++) {
-                        int idx = getIndex(row, col);
-                        newTiles[idx].value = 0;
-                    }
-                    
-                    // Place merged tiles at the edge (top for UP, bottom for DOWN)
-                    for (size_t i = 0; i < mergedValues.size(); i++) {
-                        int finalRow;
-                        size_t valueIndex;
-                        if (dir == UP) {
-                            finalRow = (int)i;  // Place from top (0, 1, 2, ...)
-                            valueIndex = i;
-                        } else { // DOWN
-                            finalRow = rows - 1 - (int)i;  // Place from bottom (3, 2, 1, ...)
-                            valueIndex = mergedValues.size() - 1 - i;  // Reverse order for values
-                        }
-                        int targetIdx = getIndex(finalRow, col);
-                        newTiles[targetIdx].value = mergedValues[valueIndex];
-                        newTiles[targetIdx].row = finalRow;
-                        newTiles[targetIdx].col = col;
-                    }
-                }
-                // If column didn't change, leave newTiles[col] as is (already copied from original)
-            }
-        } else { // LEFT or RIGHT
-            // Process each row
-            for (int row = 0; row < rows; row++) {
-                // Collect non-empty tiles with their original column positions
-                std::vector<std::pair<int, int>> rowTiles; // (col, value)
-                for (int col = 0; col < cols; col++) {
-                    int idx = getIndex(row, col);
-                    if (!originalTiles[idx].isEmpty()) {
-                        rowTiles.push_back({col, originalTiles[idx].value});
-                    }
-                }
-                
-                if (rowTiles.empty()) continue;
-                
-                // For RIGHT, we need to process from right to left for merging
-                // So we reverse the order, merge, then reverse back
-                std::vector<std::pair<int, int>> workingTiles = rowTiles;
-                bool wasReversed = false;
-                if (dir == RIGHT) {
-                    std::reverse(workingTiles.begin(), workingTiles.end());
-                    wasReversed = true;
-                }
-                
-                // Merge adjacent tiles with same value
-                std::vector<int> mergedValues; // Just the values after merging
-                for (size_t i = 0; i < workingTiles.size(); i++) {
-                    if (i < workingTiles.size() - 1 && 
-                        workingTiles[i].second == workingTiles[i + 1].second) {
-                        // Merge tiles
-                        int mergedValue = workingTiles[i].second * 2;
-                        mergedValues.push_back(mergedValue);
-                        mergeScore += mergedValue;
-                        i++; // Skip next tile as it's been merged
-                    } else {
-                        // Keep tile as is
-                        mergedValues.push_back(workingTiles[i].second);
-                    }
-                }
-                
-                // Reverse back to get correct order for placement
-                if (wasReversed) {
-                    std::reverse(mergedValues.begin(), mergedValues.end());
-                }
-                
-                // Check if this row actually needs to change
-                // Build what the final row should look like
-                std::vector<int> finalRow(cols, 0);
-                for (size_t i = 0; i < mergedValues.size(); i++) {
-                    int finalCol;
-                    if (dir == LEFT) {
-                        finalCol = (int)i;  // Place from left (0, 1, 2, ...)
-                    } else { // RIGHT
-                        finalCol = cols - 1 - (int)i;  // Place from right (3, 2, 1, ...)
-                    }
-                    finalRow[finalCol] = mergedValues[i];
-                }
-                
-                // Compare with original row - check if anything actually changed
-                bool rowChanged = false;
-                for (int col = 0; col < cols; col++) {
-                    int idx = getIndex(row, col);
-                    if (finalRow[col] != originalTiles[idx].value) {
-                        rowChanged = true;
-                        break;
-                    }
-                }
-                
-                // Only modify this row if it changed
-                if (rowChanged) {
-                    anyChange = true;
-                    // Clear this row first
-                    for (int col = 0; col < cols; col++) {
-                        int idx = getIndex(row, col);
-                        newTiles[idx].value = 0;
-                    }
-                    
-                    // Place merged tiles at the edge (left for LEFT, right for RIGHT)
-                    for (size_t i = 0; i < mergedValues.size(); i++) {
-                        int finalCol;
-                        size_t valueIndex;
-                        if (dir == LEFT) {
-                            finalCol = (int)i;  // Place from left (0, 1, 2, ...)
-                            valueIndex = i;
-                        } else { // RIGHT
-                            finalCol = cols - 1 - (int)i;  // Place from right (3, 2, 1, ...)
-                            valueIndex = mergedValues.size() - 1 - i;  // Reverse order for values
-                        }
-                        int targetIdx = getIndex(row, finalCol);
-                        newTiles[targetIdx].value = mergedValues[valueIndex];
-                        newTiles[targetIdx].row = row;
-                        newTiles[targetIdx].col = finalCol;
-                    }
-                }
-                // If row didn't change, leave newTiles[row] as is (already copied from original)
-            }
-        }
-        
-        // Only update if something changed
-        if (anyChange) {
-            tiles = newTiles;
-            return true;
-        }
-        
-        return false;
+    // Draw grid lines to separate cells (1px wide rectangles)
+    SDL_FColor lineColor = MakeColor(150, 140, 130);  // Darker gray for lines
+    float tileWidth = grid.getTileWidth();
+    float tileHeight = grid.getTileHeight();
+    
+    // Draw vertical lines
+    for (int i = 1; i < GRID_COLS; i++) {
+        float x = (float)(i * tileWidth);
+        frame.addRect(SDL_FRect{ x, 0.0f, 1.0f, (float)GRID_HEIGHT }, lineColor);
     }
-
-    // Iterate over all tiles - useful for drawing
-    // This allows range-based for loops: for (const Tile& tile : grid) { ... }
-    auto begin() const { return tiles.begin(); }
-    auto end() const { return tiles.end(); }
-    auto begin() { return tiles.begin(); }
-    auto end() { return tiles.end(); }
     
-    // Get all non-empty tiles (useful for drawing only tiles that exist)
-    std::vector<const Tile*> getNonEmptyTiles() const {
-        std::vector<const Tile*> result;
-        for (const Tile& tile : tiles) {
-            if (!tile.isEmpty()) {
-                result.push_back(&tile);
-            }
-        }
-        return result;
+    // Draw horizontal lines
+    for (int i = 1; i < GRID_ROWS; i++) {
+        float y = (float)(i * tileHeight);
+        frame.addRect(SDL_FRect{ 0.0f, y, (float)GRID_WIDTH, 1.0f }, lineColor);
     }
-};
+}
 
-// GameContext - holds game state
-struct GameContext {
-    Grid grid;
-    int score;
-    int high_score;
+// Add the score and high score. top is where HUD_AREA starts: its screen
+// position when drawing directly, 0 when drawing into the HUD layer
+void AddScore(AppState *as, float top)
+{
+    const HudText& hud = as->hud;
+    float scoreY = top + 20.0f;  // 20px below the grid
+    float labelX = 20.0f;  // Left margin for labels
+    float spacing = 15.0f;  // Space between label and value
     
-    // Constructor - initializes the grid
-    GameContext() : grid(GRID_ROWS, GRID_COLS, GRID_WIDTH, GRID_HEIGHT), 
-                    score(0), high_score(0) {}
-};
+    // Draw "Score:" label and the value after it
+    DrawHudText(as, labelX, scoreY, "Score:");
+    float scoreValueX = labelX + GetScaledTextWidth("Score:") + spacing;  // Dynamic positioning
+    DrawHudText(as, scoreValueX, scoreY, hud.score_text);
+    
+    // Draw "High Score:" label and the value after it
+    float highScoreY = scoreY + GetScaledTextHeight() + 10.0f;  // Dynamic spacing based on text height
+    DrawHudText(as, labelX, highScoreY, "High Score:");
+    float highScoreValueX = labelX + GetScaledTextWidth("High Score:") + spacing;  // Dynamic positioning
+    DrawHudText(as, highScoreValueX, highScoreY, hud.high_score_text);
+}
 
-// AppState - holds application state
-struct AppState {
-    SDL_Window *window;
-    SDL_Renderer *renderer;
-    GameContext game_ctx;
-    Uint64 last_step;
-};
+// Window pixels per logical pixel (the letterbox scale), so the layers are
+// rendered at the size they end up on screen
+float GetLayerScale(AppState *as)
+{
+    SDL_FRect presented;
+    if (!SDL_GetRenderLogicalPresentationRect(as->renderer, &presented) || presented.w <= 0.0f) {
+        return 1.0f;  // minimized, or no logical presentation
+    }
+    return presented.w / (float)SCREEN_WIDTH;
+}
 
-void InitGame(AppState *as)
+// (Re)build the tile and font atlas at the window's scale
+// Falls back to debug text if it fails
+void BuildAtlas(AppState *as)
 {
-    // Initialize random number generator with current time
-    srand((unsigned int)time(NULL));
-    
-    // Get reference to game context
-    GameContext& ctx = as->game_ctx;
-    
-    // Spawn 2 initial tiles at random positions (as per README)
-    for (int i = 0; i < 2; i++) {
-        ctx.grid.spawnRandomTile(2);
+    as->atlas.build(as->renderer, as->game_ctx.grid.getTileWidth(), as->game_ctx.grid.getTileHeight(),
+                    GetLayerScale(as));
+}
+
+// Render the background layer: background color, grid and grid lines
+void BuildBackgroundLayer(AppState *as)
+{
+    SDL_Renderer* renderer = as->renderer;
+    if (!as->background_layer.begin(renderer, SCREEN_WIDTH, SCREEN_HEIGHT, GetLayerScale(as))) {
+        return;
+    }
+    SDL_SetRenderDrawColor(renderer, 250, 248, 239, 255);  // Light beige background
+    SDL_RenderClear(renderer);
+    as->frame.begin();
+    AddBackground(as);
+    as->frame.submit(renderer);
+    as->background_layer.end(renderer);
+}
+
+// Render the HUD layer: score and high score on a transparent background
+void BuildHudLayer(AppState *as)
+{
+    SDL_Renderer* renderer = as->renderer;
+    if (!as->hud_layer.begin(renderer, (int)HUD_AREA.w, (int)HUD_AREA.h, GetLayerScale(as))) {
+        return;
     }
+    as->frame.begin();
+    AddScore(as, 0.0f);
+    as->frame.submit(renderer);
+    as->hud_layer.end(renderer);
 }
 
-void UpdateGame(AppState *as)
+// Add the performance overlay (if shown), present the frame and record its statistics
+// The game must already be submitted
+void PresentFrame(AppState *as)
 {
-    // Game update logic will go here (movement, merging, etc.)
-    // update scores
+    TRACE_SCOPE("PresentFrame");
+    SDL_Renderer* renderer = as->renderer;
+    FrameBuilder& frame = as->frame;
+    
+    // Performance overlay on top, as its own small batch (only when shown)
+    int drawCalls = frame.getDrawCalls();
+    int vertices = frame.getVertexCount();
+    if (as->overlay.isVisible()) {
+        frame.begin();
+        as->overlay.draw(frame, as->atlas);
+        frame.submit(renderer);
+        as->overlay.drawDebugText(renderer);  // only if there was no atlas for the text
+    }
     
+    as->pacer.beginPresent();
+    SDL_RenderPresent(renderer);
+    as->pacer.endPresent();
+    
+    // Frame statistics for the overlay (frame time only between back-to-back frames)
+    Uint64 now = SDL_GetTicksNS();
+    if (as->move_on_way) {
+        // First frame showing the newest move: its trace is complete
+        as->move_timing.presentedNs = now;
+        as->latency.record(as->move_timing);
+        as->overlay.recordMoveLatency(now - as->move_timing.keyNs);
+        as->move_on_way = false;
+    }
+    // Everything allocated since the previous present (on any thread) counts
+    // for this frame; the first frame would get all of the startup
+    Uint64 allocations = GetAllocationCount() + GetSdlAllocationCount();
+    Uint64 allocatedBytes = GetAllocatedBytes() + GetSdlAllocatedBytes();
+    Uint64 frameAllocations = allocations - as->allocation_mark;
+    Uint64 frameBytes = allocatedBytes - as->allocated_bytes_mark;
+    if (as->last_present_ns != 0) {
+        as->frame_allocations.add(frameAllocations, frameBytes);
+    }
+    Uint64 frameNs = as->drew_last_iterate ? now - as->last_present_ns : 0;
+    as->overlay.recordFrame(frameNs, drawCalls, vertices, frameAllocations, frameBytes);
+    if (as->script.active) {
+        as->script.frames++;
+        if (frameNs > 0) {
+            as->script.frame_times.record(frameNs);
+        }
+    }
+    as->last_present_ns = now;
+    as->allocation_mark = allocations;
+    as->allocated_bytes_mark = allocatedBytes;
 }
 
 void DrawGame(AppState *as)
 {
+    TRACE_SCOPE("DrawGame");
     SDL_Renderer* renderer = as->renderer;
     const Grid& grid = as->game_ctx.grid;
+    FrameBuilder& frame = as->frame;
     
-    // Step 1: Clear the screen with background color
+    // Step 1: Update the cached layers that are out of date
+    // The score strings (and the HUD layer) only change when the values change
+    const GameContext& ctx = as->game_ctx;
+    HudText& hud = as->hud;
+    if (!hud.valid || hud.score != ctx.score || hud.high_score != ctx.high_score) {
+        hud.score = ctx.score;
+        hud.high_score = ctx.high_score;
+        snprintf(hud.score_text, sizeof(hud.score_text), "%d", ctx.score);
+        snprintf(hud.high_score_text, sizeof(hud.high_score_text), "%d", ctx.high_score);
+        hud.valid = true;
+        as->hud_layer.invalidate();
+    }
+    // The atlas is rasterized at the window's scale like the layers; after a
+    // resize it is rebuilt first, since the HUD layer draws from it
+    if (as->atlas.isReady() && as->atlas.getScale() != GetLayerScale(as)) {
+        BuildAtlas(as);
+        as->hud_layer.invalidate();
+    }
+    if (!as->background_layer.isValid()) {
+        BuildBackgroundLayer(as);
+    }
+    if (!as->hud_layer.isValid()) {
+        BuildHudLayer(as);
+    }
+    
+    // Step 2: Clear the screen (this also fills the letterbox bars)
+    frame.begin();
     SDL_SetRenderDrawColor(renderer, 250, 248, 239, 255);  // Light beige background
     SDL_RenderClear(renderer);
     
-    // Step 2: Draw the grid background
-    SDL_FRect gridRect = grid.getRect();
-    SDL_SetRenderDrawColor(renderer, 187, 173, 160, 255);  // Dark beige
-    SDL_RenderFillRect(renderer, &gridRect);
+    // Step 3: Background and grid, one quad from the layer (or drawn directly)
+    if (as->background_layer.isValid()) {
+        SDL_FRect screen = { 0.0f, 0.0f, (float)SCREEN_WIDTH, (float)SCREEN_HEIGHT };
+        frame.addTexturedRect(as->background_layer.getTexture(), as->background_layer.getTextureRect(), screen);
+    } else {
+        AddBackground(as);
+    }
     
-    // Step 3: Draw grid lines to separate cells
-    SDL_SetRenderDrawColor(renderer, 150, 140, 130, 255);  // Darker gray for lines
+    // Step 4: Draw all non-empty tiles (where the animation has them, if one is running)
+    // With the atlas every tile is one textured quad with its number already on it
     float tileWidth = grid.getTileWidth();
     float tileHeight = grid.getTileHeight();
+    bool tileTextMissing = false;
+    auto addTile = [&](int value, const SDL_FRect& tileRect) {
+        if (!as->atlas.addTile(frame, value, tileRect)) {
+            // No atlas (or a value it doesn't have): plain tile, number drawn after the batch
+            Uint8 r, g, b;
+            Tile(value).getColor(r, g, b);
+            frame.addRect(tileRect, MakeColor(r, g, b));
+            tileTextMissing = true;
+        }
+    };
+    if (as->animator.isAnimating()) {
+        as->animator.forEachSprite(grid, [&](const TileSprite& sprite) {
+            addTile(sprite.value, sprite.rect);
+        });
+    } else {
+        for (const Tile& tile : grid) {
+            if (!tile.isEmpty()) {
+                addTile(tile.value, tile.getRect(tileWidth, tileHeight));
+            }
+        }
+    }
     
-    // Draw vertical lines
-    for (int i = 1; i < GRID_COLS; i++) {
-        float x = (float)(i * tileWidth);
-        SDL_RenderLine(renderer, x, 0.0f, x, GRID_HEIGHT);
+    // Step 5: Draw score and high score below the grid, one quad from the layer
+    if (as->hud_layer.isValid()) {
+        frame.addTexturedRect(as->hud_layer.getTexture(), as->hud_layer.getTextureRect(), HUD_AREA);
+    } else {
+        AddScore(as, HUD_AREA.y);
     }
     
-    // Draw horizontal lines
-    for (int i = 1; i < GRID_ROWS; i++) {
-        float y = (float)(i * tileHeight);
-        SDL_RenderLine(renderer, 0.0f, y, GRID_WIDTH, y);
+    if (as->replay.active) {
+        DrawReplayControls(as, HUD_AREA.y + 20.0f);
     }
     
-    // Step 4: Draw all non-empty tiles using range-based for loop
-    // This is much cleaner than nested loops!
-    for (const Tile* tilePtr : grid.getNonEmptyTiles()) {
-        const Tile& tile = *tilePtr;
-        
-        // Get the rectangle and color for this tile
-        SDL_FRect tileRect = tile.getRect(tileWidth, tileHeight);
-        Uint8 r, g, b;
-        tile.getColor(r, g, b);
+    // Send the whole frame: one SDL_RenderGeometry per texture (layers, atlas) and one for plain shapes
+    frame.submit(renderer);
+    
+    // Debug text fallback for tile numbers goes on top of the batch
+    // (only on a still board; it is drawn at the tiles' final cells)
+    if (tileTextMissing && !as->animator.isAnimating()) {
+        for (const Tile& tile : grid) {
+            if (!tile.isEmpty() && !(as->atlas.isReady() && tile.value <= (1 << TextureAtlas::MAX_EXPONENT))) {
+                DrawTileText(renderer, tile, tileWidth, tileHeight);
+            }
+        }
+    }
+    
+    // Step 6: Present the rendered frame to the screen
+    PresentFrame(as);
+}
+
+
+
+// Draw every tournament game as a miniature board, all in one batch
+// (one SDL_RenderGeometry for the board backgrounds, one for the tiles)
+void DrawTournament(AppState *as)
+{
+    SDL_Renderer* renderer = as->renderer;
+    FrameBuilder& frame = as->frame;
+    const Tournament& tournament = as->spectator.tournament;
+    frame.begin();
+    
+    SDL_SetRenderDrawColor(renderer, 250, 248, 239, 255);  // Light beige background
+    SDL_RenderClear(renderer);
+    
+    // Square layout filling the grid area, with a small gap between boards
+    int games = tournament.getGameCount();
+    int columns = (int)SDL_ceil(SDL_sqrt((double)games));
+    float boardSize = (float)GRID_WIDTH / columns;
+    float gap = SDL_max(1.0f, boardSize * 0.05f);
+    float cellSize = (boardSize - gap) / BOARD_SIZE;
+    float cellGap = cellSize * 0.08f;
+    SDL_FColor boardColor = MakeColor(187, 173, 160);  // Dark beige
+    
+    for (int game = 0; game < games; game++) {
+        float x = (game % columns) * boardSize + gap / 2.0f;
+        float y = (game / columns) * boardSize + gap / 2.0f;
+        frame.addRect(SDL_FRect{ x, y, boardSize - gap, boardSize - gap }, boardColor);
         
-        // Draw the tile background
-        SDL_SetRenderDrawColor(renderer, r, g, b, 255);
-        SDL_RenderFillRect(renderer, &tileRect);
+        // The newest state the game's worker has published
+        Board board = tournament.getBoard(game);
+        for (int cell = 0; cell < BOARD_CELLS; cell++) {
+            int exponent = BoardGetExponent(board, cell);
+            if (exponent == 0) {
+                continue;
+            }
+            SDL_FRect tileRect = {
+                x + (cell % BOARD_SIZE) * cellSize + cellGap / 2.0f,
+                y + (cell / BOARD_SIZE) * cellSize + cellGap / 2.0f,
+                cellSize - cellGap,
+                cellSize - cellGap
+            };
+            if (!as->atlas.addTile(frame, 1 << exponent, tileRect)) {
+                Uint8 r, g, b;
+                Tile(1 << exponent).getColor(r, g, b);
+                frame.addRect(tileRect, MakeColor(r, g, b));
+            }
+        }
+    }
+    
+    // Totals below the boards
+    char text[64];
+    float textY = HUD_AREA.y + 20.0f;
+    snprintf(text, sizeof(text), "Games: %d  Finished: %d", games, tournament.getGamesFinished());
+    DrawHudText(as, 20.0f, textY, text);
+    int speed = tournament.getSpeed();
+    snprintf(text, sizeof(text), "Moves/s: %.0f  Best: %d  x%d", as->spectator.moves_per_second,
+             tournament.getBestExponent() > 0 ? 1 << tournament.getBestExponent() : 0, speed);
+    DrawHudText(as, 20.0f, textY + GetScaledTextHeight() + 10.0f, text);
+    
+    frame.submit(renderer);
+    PresentFrame(as);
+}
+
+
+
+// HEADLESS RENDERING
+// --golden, --render-bench and --export-video run DrawGame with SDL's software renderer
+// drawing into a plain surface, under the dummy video driver: no window,
+// display or GPU needed (CI hosts).
+
+// Board states for golden frames and render benchmarks
+// Always built the same way, so the frames are the same on every run
+const char* const BENCH_BOARDS[] = { "start", "early", "mid", "late", "all-tiles" };
+const int BENCH_BOARD_COUNT = SDL_arraysize(BENCH_BOARDS);
+
+void SetUpBenchBoard(GameContext& ctx, int index)
+{
+    ctx.high_score = 0;
+    NewGame(ctx, 2048 + (Uint64)index);
+    if (index == 4) {
+        // Every tile value from 2 up, for checking the whole atlas
+        for (int i = 0; i < (int)ctx.grid.size(); i++) {
+            ctx.grid.at(i).value = 2 << i;
+        }
+        ctx.score = 123456;
+        ctx.high_score = 654321;
+        return;
+    }
+    
+    // Play a fixed number of turns (or until the game is over) with moves
+    // from their own random sequence
+    const int turns[] = { 0, 50, 300, 100000 };
+    Rng moves(index);
+    for (int turn = 0; turn < turns[index]; turn++) {
+        int first = moves.below(4);
+        bool moved = false;
+        for (int i = 0; i < 4 && !moved; i++) {
+            moved = PlayTurn(ctx, (Grid::Direction)((first + i) % 4));
+        }
+        if (!moved) {
+            break;
+        }
+    }
+}
+
+// Make a software renderer that draws into as->headless_surface
+bool CreateHeadlessRenderer(AppState *as)
+{
+    as->headless_surface = SDL_CreateSurface(SCREEN_WIDTH, SCREEN_HEIGHT, SDL_PIXELFORMAT_XRGB8888);
+    if (!as->headless_surface) {
+        SDL_Log("Couldn't create frame surface: %s", SDL_GetError());
+        return false;
+    }
+    as->renderer = SDL_CreateSoftwareRenderer(as->headless_surface);
+    if (!as->renderer) {
+        SDL_Log("Couldn't create software renderer: %s", SDL_GetError());
+        return false;
+    }
+    renderer = as->renderer;
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    return true;
+}
+
+// Compare a frame with a golden image. Writes the golden image if there is none yet
+// Returns false if they differ
+bool CheckGoldenFrame(SDL_Surface* frame, const char* path)
+{
+    SDL_Surface* loaded = SDL_LoadBMP(path);
+    if (!loaded) {
+        if (!SDL_SaveBMP(frame, path)) {
+            SDL_Log("Couldn't write %s: %s", path, SDL_GetError());
+            return false;
+        }
+        printf("NEW   %s\n", path);
+        return true;
+    }
+    SDL_Surface* golden = SDL_ConvertSurface(loaded, frame->format);
+    SDL_DestroySurface(loaded);
+    if (!golden || golden->w != frame->w || golden->h != frame->h) {
+        printf("FAIL  %s: size differs\n", path);
+        SDL_DestroySurface(golden);
+        return false;
+    }
+    
+    // Count the pixels that differ (ignoring the unused X byte of XRGB)
+    int differing = 0;
+    for (int y = 0; y < frame->h; y++) {
+        const Uint32* a = (const Uint32*)((const Uint8*)frame->pixels + y * frame->pitch);
+        const Uint32* b = (const Uint32*)((const Uint8*)golden->pixels + y * golden->pitch);
+        for (int x = 0; x < frame->w; x++) {
+            if ((a[x] & 0xFFFFFF) != (b[x] & 0xFFFFFF)) {
+                differing++;
+            }
+        }
+    }
+    SDL_DestroySurface(golden);
+    if (differing > 0) {
+        printf("FAIL  %s: %d pixels differ\n", path, differing);
+        return false;
+    }
+    printf("OK    %s\n", path);
+    return true;
+}
+
+// --golden <dir>: draw every bench board and compare it with <dir>/<board>.bmp
+// (missing images are written, so the first run creates the set)
+bool RunGoldenFrames(AppState *as, const char* dir)
+{
+    bool ok = true;
+    for (int i = 0; i < BENCH_BOARD_COUNT; i++) {
+        SetUpBenchBoard(as->game_ctx, i);
+        DrawGame(as);
+        std::string path = std::string(dir) + "/" + BENCH_BOARDS[i] + ".bmp";
+        ok = CheckGoldenFrame(as->headless_surface, path.c_str()) && ok;
+    }
+    return ok;
+}
+
+// --render-bench <frames>: draw each bench board `frames` times and report the speed
+void RunRenderBenchmark(AppState *as, int frames)
+{
+    printf("%-10s %10s %10s %6s %8s\n", "board", "fps", "ms/frame", "draws", "verts");
+    for (int i = 0; i < BENCH_BOARD_COUNT; i++) {
+        SetUpBenchBoard(as->game_ctx, i);
+        DrawGame(as);  // warm up: layers and HUD text are built on the first frame
         
-        // Draw the tile's number text
-        tile.drawText(renderer, tileWidth, tileHeight);
+        Uint64 start = SDL_GetTicksNS();
+        for (int frame = 0; frame < frames; frame++) {
+            DrawGame(as);
+        }
+        double seconds = (double)(SDL_GetTicksNS() - start) / 1e9;
+        printf("%-10s %10.1f %10.3f %6d %8d\n", BENCH_BOARDS[i], frames / seconds,
+               seconds * 1000.0 / frames, as->frame.getDrawCalls(), as->frame.getVertexCount());
     }
+}
+
+// --export-video <replay> <file>: draw the replay one turn per frame and
+// write it as a video (see VideoWriter). Drawing runs here while the writer
+// thread converts and writes the previous frames
+bool RunVideoExport(AppState *as, const char* replayPath, const char* videoPath, int fps)
+{
+    Replay replay;
+    std::string error;
+    if (!LoadReplay(replayPath, replay, &error) || !as->replay.player.load(replay, as->game_ctx, &error)) {
+        SDL_Log("Couldn't load replay: %s", error.c_str());
+        return false;
+    }
+    as->replay.active = true;  // show the progress bar
+    as->replay.paused = true;
     
-    // Step 5: Draw score and high score below the grid
-    const GameContext& ctx = as->game_ctx;
-    float scoreY = GRID_HEIGHT + 20.0f;  // 20px below the grid
-    float labelX = 20.0f;  // Left margin for labels
-    float spacing = 15.0f;  // Space between label and value
+    VideoWriter writer;
+    if (!writer.open(videoPath, SCREEN_WIDTH, SCREEN_HEIGHT, fps, &error)) {
+        SDL_Log("Couldn't export video: %s", error.c_str());
+        return false;
+    }
+    
+    Uint64 start = SDL_GetTicksNS();
+    ReplayPlayer& player = as->replay.player;
+    bool ok = true;
+    for (int turn = 0; turn <= player.length() && ok; turn++) {
+        player.seek(turn, as->game_ctx);
+        DrawGame(as);
+        ok = writer.addFrame(as->headless_surface->pixels, as->headless_surface->pitch);
+    }
+    ok = writer.close(&error) && ok;
+    if (!ok) {
+        SDL_Log("Couldn't export video: %s", error.c_str());
+        return false;
+    }
     
-    // Draw "Score:" label (using scaled text)
-    SDL_SetRenderDrawColor(renderer, 119, 110, 101, 255);  // Dark gray
-    RenderScaledText(renderer, labelX, scoreY, "Score:");
-    
-    // Calculate position for score value based on actual text width
-    float scoreLabelWidth = GetScaledTextWidth("Score:");
-    char scoreText[32];
-    snprintf(scoreText, sizeof(scoreText), "%d", ctx.score);
-    float scoreValueX = labelX + scoreLabelWidth + spacing;  // Dynamic positioning
-    RenderScaledText(renderer, scoreValueX, scoreY, scoreText);
-    
-    // Draw "High Score:" label
-    float textHeight = GetScaledTextHeight();
-    float highScoreY = scoreY + textHeight + 10.0f;  // Dynamic spacing based on text height
-    RenderScaledText(renderer, labelX, highScoreY, "High Score:");
-    
-    // Calculate position for high score value based on actual text width
-    float highScoreLabelWidth = GetScaledTextWidth("High Score:");
-    char highScoreText[32];
-    snprintf(highScoreText, sizeof(highScoreText), "%d", ctx.high_score);
-    float highScoreValueX = labelX + highScoreLabelWidth + spacing;  // Dynamic positioning
-    RenderScaledText(renderer, highScoreValueX, highScoreY, highScoreText);
+    double seconds = (double)(SDL_GetTicksNS() - start) / 1e9;
+    printf("%s: %d frames, %dx%d %s at %d fps, exported in %.1f s (%.0f frames/s)\n", videoPath,
+           writer.getFramesWritten(), SCREEN_WIDTH, SCREEN_HEIGHT, writer.isY4m() ? "Y4M 4:4:4" : "raw RGB24",
+           fps, seconds, writer.getFramesWritten() / seconds);
+    return true;
+}
+
+
+
+// INPUT SCRIPTS
+// Print what a finished --input-script run measured
+void PrintScriptReport(AppState *as)
+{
+    ScriptRun& script = as->script;
+    double seconds = (double)(SDL_GetTicksNS() - script.start_ns) / 1e9;
+    size_t presses = script.input.getEventCount();
+    char speed[32];
+    if (script.input.getSpeed() > 0.0) {
+        snprintf(speed, sizeof(speed), "%gx script speed", script.input.getSpeed());
+    } else {
+        snprintf(speed, sizeof(speed), "as fast as possible");
+    }
+    printf("%zu key presses in %.3f s, %s\n", presses, seconds, speed);
+    printf("events    %10llu  %10.1f per second (all SDL_AppEvent calls)\n",
+           (unsigned long long)script.events.load(), script.events.load() / seconds);
+    printf("keys      %10zu  %10.1f per second\n", presses, presses / seconds);
+    printf("frames    %10llu  %10.1f per second\n", (unsigned long long)script.frames, script.frames / seconds);
     
-    // Step 6: Present the rendered frame to the screen
-    SDL_RenderPresent(renderer);
+    const LatencyHistogram& frames = script.frame_times;
+    const LatencyHistogram& latency = as->latency.getStage(LatencyTrace::TOTAL);
+    printf("%-22s %8s %8s %8s %8s %8s\n", "ms", "mean", "p50", "p90", "p99", "max");
+    printf("%-22s %8.3f %8.3f %8.3f %8.3f %8.3f\n", "frame time", frames.getMean() / 1e6,
+           frames.getPercentile(50) / 1e6, frames.getPercentile(90) / 1e6,
+           frames.getPercentile(99) / 1e6, frames.getMax() / 1e6);
+    printf("%-22s %8.3f %8.3f %8.3f %8.3f %8.3f\n", "key to present", latency.getMean() / 1e6,
+           latency.getPercentile(50) / 1e6, latency.getPercentile(90) / 1e6,
+           latency.getPercentile(99) / 1e6, latency.getMax() / 1e6);
+}
+
+// ALLOCATIONS
+// Print where --alloc-report saw memory being allocated (the game thread must be stopped)
+void PrintAllocationReport(AppState *as)
+{
+    printf("Allocations: operator new %llu (%llu bytes), SDL_malloc %llu (%llu bytes)\n",
+           (unsigned long long)GetAllocationCount(), (unsigned long long)GetAllocatedBytes(),
+           (unsigned long long)GetSdlAllocationCount(), (unsigned long long)GetSdlAllocatedBytes());
+    as->frame_allocations.print(stdout, "frames");
+    as->game_thread.getMoveAllocations().print(stdout, "moves");
+    PrintAllocationSites(stdout, 20);
 }
 
 
@@ -628,112 +930,428 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char **argv)
 {
     SDL_SetAppMetadata("2048 Game made with SDL 3", "0.0.1", "com.siekwie.2048Game");
 
+    // Command line: --replay <file> plays a recorded game, --record <file> saves the played game
+    // --vsync on|off|adaptive, --fps-cap <n> and --late-latch choose how frames are presented
+    // --golden <dir> and --render-bench <frames> render without a window and exit
+    // --tournament <games> watches up to 1024 AI games at once
+    // --export-video <replay> <file> [--video-fps <n>] writes a replay as a .y4m (or raw RGB) video
+    // --latency prints where the time between key press and screen went, on exit
+    // --key-repeat paced|off|on chooses what holding a key down does
+    // --input-script <file> [--script-speed <x>] presses scripted keys, reports the speed and exits
+    // --trace <file> writes a Chrome trace of the session on exit (builds with GAME2048_TRACE)
+    // --alloc-report counts SDL's allocations too and prints allocations per frame, per move and by call site on exit
+    const char* replayPath = NULL;
+    const char* recordPath = NULL;
+    const char* goldenDir = NULL;
+    int benchFrames = 0;
+    int tournamentGames = 0;
+    const char* exportReplay = NULL;
+    const char* exportPath = NULL;
+    int videoFps = 30;
+    bool printLatency = false;
+    KeyRepeatPolicy keyRepeat = KEY_REPEAT_PACED;
+    const char* scriptPath = NULL;
+    double scriptSpeed = 1.0;
+    const char* tracePath = NULL;
+    bool allocReport = false;
+    PresentOptions present;
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--replay") == 0 && hasValue) {
+            replayPath = argv[++i];
+        } else if (strcmp(argv[i], "--record") == 0 && hasValue) {
+            recordPath = argv[++i];
+        } else if (strcmp(argv[i], "--vsync") == 0 && hasValue) {
+            const char* mode = argv[++i];
+            if (strcmp(mode, "off") == 0) {
+                present.vsync = 0;
+            } else if (strcmp(mode, "adaptive") == 0) {
+                present.vsync = SDL_RENDERER_VSYNC_ADAPTIVE;
+            } else {
+                present.vsync = 1;
+            }
+        } else if (strcmp(argv[i], "--fps-cap") == 0 && hasValue) {
+            present.fpsCap = SDL_max(atoi(argv[++i]), 0);
+        } else if (strcmp(argv[i], "--late-latch") == 0) {
+            present.lateLatch = true;
+        } else if (strcmp(argv[i], "--golden") == 0 && hasValue) {
+            goldenDir = argv[++i];
+        } else if (strcmp(argv[i], "--render-bench") == 0 && hasValue) {
+            benchFrames = SDL_max(atoi(argv[++i]), 1);
+        } else if (strcmp(argv[i], "--tournament") == 0 && hasValue) {
+            tournamentGames = SDL_clamp(atoi(argv[++i]), 1, Tournament::MAX_GAMES);
+        } else if (strcmp(argv[i], "--export-video") == 0 && i + 2 < argc) {
+            exportReplay = argv[++i];
+            exportPath = argv[++i];
+        } else if (strcmp(argv[i], "--video-fps") == 0 && hasValue) {
+            videoFps = SDL_clamp(atoi(argv[++i]), 1, 240);
+        } else if (strcmp(argv[i], "--latency") == 0) {
+            printLatency = true;
+        } else if (strcmp(argv[i], "--key-repeat") == 0 && hasValue) {
+            const char* mode = argv[++i];
+            if (strcmp(mode, "off") == 0) {
+                keyRepeat = KEY_REPEAT_OFF;
+            } else if (strcmp(mode, "on") == 0) {
+                keyRepeat = KEY_REPEAT_ON;
+            } else {
+                keyRepeat = KEY_REPEAT_PACED;
+            }
+        } else if (strcmp(argv[i], "--input-script") == 0 && hasValue) {
+            scriptPath = argv[++i];
+        } else if (strcmp(argv[i], "--script-speed") == 0 && hasValue) {
+            scriptSpeed = SDL_max(SDL_atof(argv[++i]), 0.0);  // 0 = as fast as possible
+        } else if (strcmp(argv[i], "--trace") == 0 && hasValue) {
+            tracePath = argv[++i];
+        } else if (strcmp(argv[i], "--alloc-report") == 0) {
+            allocReport = true;
+        }
+    }
+    // SDL's memory functions have to be swapped before SDL_Init allocates much
+    if (allocReport && !EnableAllocationTracking()) {
+        SDL_Log("Couldn't track SDL's allocations: %s", SDL_GetError());
+    }
+    bool headless = goldenDir || benchFrames > 0 || exportPath;
+    if (headless) {
+        // No display needed: the dummy video driver never opens one
+        SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "dummy");
+    }
+
     if (!SDL_Init(SDL_INIT_VIDEO)) {
         SDL_Log("Couldn't initialize SDL: %s", SDL_GetError());
         return SDL_APP_FAILURE;
     }
 
-    // Use placement new to properly construct AppState (which contains GameContext with constructor)
-    // SDL_calloc zero-initializes memory but doesn't call constructors
-    AppState *as = (AppState *)SDL_calloc(1, sizeof(AppState));
-    if (!as) {
-        SDL_Quit();
-        return SDL_APP_FAILURE;
+    // AppState() (with the parentheses) zeroes the plain members and constructs
+    // the others. new also honours the alignas(64) members of the game thread's
+    // queue, which SDL_calloc would not
+    AppState *as = new AppState();
+    as->record_path = recordPath;
+    as->print_latency = printLatency;
+    as->trace_path = tracePath;
+    as->alloc_report = allocReport;
+#ifndef GAME2048_TRACE
+    if (tracePath) {
+        SDL_Log("--trace needs a build configured with -DGAME2048_TRACE=ON");
+    }
+#endif
+    TRACE_THREAD_NAME("main");
+    as->key_repeat = keyRepeat;
+    as->animation_speed = 1.0f;
+    *appstate = as;
+
+    if (headless) {
+        if (!CreateHeadlessRenderer(as)) {
+            return SDL_APP_FAILURE;
+        }
+        as->atlas.build(as->renderer, as->game_ctx.grid.getTileWidth(), as->game_ctx.grid.getTileHeight());
+        bool ok = true;
+        if (goldenDir) {
+            ok = RunGoldenFrames(as, goldenDir);
+        }
+        if (benchFrames > 0) {
+            RunRenderBenchmark(as, benchFrames);
+        }
+        if (exportPath) {
+            ok = RunVideoExport(as, exportReplay, exportPath, videoFps) && ok;
+        }
+        return ok ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
     }
-    // Use placement new to call the GameContext constructor
-    new (&as->game_ctx) GameContext();
 
     if (!SDL_CreateWindowAndRenderer("2048", SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_RESIZABLE, &window, &renderer)) {
         SDL_Log("Couldn't create window/renderer: %s", SDL_GetError());
-        SDL_free(as);
-        SDL_Quit();
         return SDL_APP_FAILURE;
     }
     SDL_SetRenderLogicalPresentation(renderer, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_LOGICAL_PRESENTATION_LETTERBOX);
+    as->pacer.configure(renderer, window, present);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);  // for the overlay's see-through panel
 
     // Now set the window and renderer in AppState after they're created
     as->window = window;
     as->renderer = renderer;
-    *appstate = as;
     
-    // Initialize the game
-    InitGame(as);
-
+    // Build the tile and font atlas (again after a resize, see DrawGame)
+    BuildAtlas(as);
+    
+    // Initialize the game, or load the replay to show, or start the AI games
+    if (tournamentGames > 0) {
+        as->spectator.tournament.start(tournamentGames, 0, (Uint64)time(NULL));
+        as->spectator.active = true;
+        as->spectator.mark_ns = SDL_GetTicksNS();
+    } else if (replayPath) {
+        Replay replay;
+        std::string error;
+        if (!LoadReplay(replayPath, replay, &error) || !as->replay.player.load(replay, as->game_ctx, &error)) {
+            SDL_Log("Couldn't load replay: %s", error.c_str());
+            return SDL_APP_FAILURE;
+        }
+        as->replay.active = true;
+        as->replay.speed = REPLAY_DEFAULT_SPEED;
+        as->replay.last_ns = SDL_GetTicksNS();
+    } else if (scriptPath) {
+        // A fresh game from a fixed seed (the saved session is left alone),
+        // played by the script's key presses
+        std::string error;
+        if (!as->script.input.load(scriptPath, &error)) {
+            SDL_Log("Couldn't load input script: %s", error.c_str());
+            return SDL_APP_FAILURE;
+        }
+        as->script.active = true;  // before the game thread can send events
+        as->game_thread.start(as->record_path, SDL_RegisterEvents(1), SCRIPT_SEED);
+        ApplySnapshot(as);
+        as->script.input.start(scriptSpeed);
+        as->script.start_ns = SDL_GetTicksNS();
+    } else {
+        // Continue the previous session (or start a new game) on the game thread
+        // It wakes the main loop with an event after every change
+        as->game_thread.start(as->record_path, SDL_RegisterEvents(1));
+        ApplySnapshot(as);
+    }
 
-    as->last_step = SDL_GetTicks();
+    as->last_step = SDL_GetTicksNS();
+    RequestRedraw(as);
     return SDL_APP_CONTINUE;  /* carry on with the program! */
 }
 
 SDL_AppResult SDL_AppIterate(void *appstate)
 {
+    TRACE_SCOPE("SDL_AppIterate");
     // Cast void* to AppState* - we know it's actually an AppState pointer
     AppState *as = (AppState *)appstate;
+    
+    // Scripted run: queue the keys that are due. SDL hands them to
+    // SDL_AppEvent after this iterate returns, so the run is only done once
+    // SDL_AppEvent has handled every one and the game thread has applied
+    // them; then this iterate picks up the last move
+    bool scriptDone = false;
+    if (as->script.active) {
+        as->script.input.inject(SDL_GetWindowID(as->window));
+        scriptDone = as->script.input.isFinished() &&
+                     as->script.keys.load() >= as->script.input.getEventCount() &&
+                     as->game_thread.isCaughtUp();
+    }
     UpdateGame(as);
-    DrawGame(as);
+    
+    // Only draw when something changed, and not into a window nobody can see
+    bool drew = false;
+    if (as->needs_redraw && !as->window_hidden) {
+        // Wait for this frame's turn (frame cap / late latch). With late latch,
+        // handle the input that arrived while waiting and let the game thread
+        // apply it, so those key presses are already in this frame
+        as->pacer.waitForFrame();
+        if (as->pacer.isLateLatch()) {
+            // SDL_PumpEvents only queues the keys: the main callbacks hand queued
+            // events to SDL_AppEvent between iterates. Take them out of the
+            // queue and handle them here instead, before drawing
+            SDL_PumpEvents();
+            SDL_Event keys[16];
+            int count;
+            while ((count = SDL_PeepEvents(keys, SDL_arraysize(keys), SDL_GETEVENT,
+                                           SDL_EVENT_KEY_DOWN, SDL_EVENT_KEY_UP)) > 0) {
+                for (int i = 0; i < count; i++) {
+                    SDL_AppResult result = SDL_AppEvent(as, &keys[i]);
+                    if (result != SDL_APP_CONTINUE) {
+                        return result;
+                    }
+                }
+            }
+            as->game_thread.waitUntilApplied(LATE_LATCH_APPLY_TIMEOUT_NS);
+            UpdateGame(as);
+        }
+        as->pacer.beginDraw();
+        if (as->spectator.active) {
+            DrawTournament(as);
+        } else {
+            DrawGame(as);
+        }
+        as->needs_redraw = false;
+        drew = true;
+    }
+    as->drew_last_iterate = drew;
+    
+    // ... and ends when that move has been animated and shown
+    if (scriptDone && !as->animator.isAnimating() && !as->needs_redraw) {
+        PrintScriptReport(as);
+        return SDL_APP_SUCCESS;
+    }
+    
+    // Pick how soon to come back: right away while playing, otherwise
+    // sleep until the next event (the game thread sends one after each move)
+    if (IsAnimating(as) && !as->window_hidden) {
+        SetCallbackRate(as, CALLBACK_RATE_ACTIVE);
+    } else if (IsAnimating(as)) {
+        SetCallbackRate(as, CALLBACK_RATE_BACKGROUND);
+    } else {
+        SetCallbackRate(as, CALLBACK_RATE_IDLE);
+    }
     return SDL_APP_CONTINUE;  /* carry on with the program! */
 }
 SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event)
 {
+    TRACE_SCOPE("SDL_AppEvent");
     // SDL_AppEvent is called once per event, no need to poll in a loop
+    if (appstate != NULL && ((AppState *)appstate)->script.active) {
+        ((AppState *)appstate)->script.events++;
+        if (InputScript::isScripted(*event)) {
+            ((AppState *)appstate)->script.keys++;
+        }
+    }
     switch (event->type) {
         case SDL_EVENT_QUIT:
             return SDL_APP_SUCCESS;  /* end the program, reporting success to the OS. */
         case SDL_EVENT_WINDOW_CLOSE_REQUESTED:
             return SDL_APP_SUCCESS;  /* end the program, reporting success to the OS. */
+        case SDL_EVENT_RENDER_TARGETS_RESET:
+        case SDL_EVENT_RENDER_DEVICE_RESET: {
+            // The atlas and layer textures' contents are gone; render them again
+            AppState *as = (AppState *)appstate;
+            BuildAtlas(as);
+            as->background_layer.invalidate();
+            as->hud_layer.invalidate();
+            RequestRedraw(as);
+            break;
+        }
+        case SDL_EVENT_WINDOW_HIDDEN:
+        case SDL_EVENT_WINDOW_MINIMIZED:
+        case SDL_EVENT_WINDOW_OCCLUDED: {
+            // Stop drawing until the window can be seen again
+            AppState *as = (AppState *)appstate;
+            as->window_hidden = true;
+            break;
+        }
+        case SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED: {
+            // Resized: rebuild the cached layers at the new pixel size
+            AppState *as = (AppState *)appstate;
+            as->background_layer.invalidate();
+            as->hud_layer.invalidate();
+            as->window_hidden = false;
+            RequestRedraw(as);
+            break;
+        }
+        case SDL_EVENT_WINDOW_SHOWN:
+        case SDL_EVENT_WINDOW_RESTORED:
+        case SDL_EVENT_WINDOW_MAXIMIZED:
+        case SDL_EVENT_WINDOW_EXPOSED: {
+            // Visible again: the old picture has to be redrawn
+            AppState *as = (AppState *)appstate;
+            as->window_hidden = false;
+            RequestRedraw(as);
+            break;
+        }
+        case SDL_EVENT_MOUSE_BUTTON_DOWN:
+        case SDL_EVENT_MOUSE_MOTION:
+        case SDL_EVENT_MOUSE_BUTTON_UP: {
+            // Scrub the replay by dragging on the progress bar
+            AppState *as = (AppState *)appstate;
+            if (!as->replay.active) {
+                break;
+            }
+            SDL_ConvertEventToRenderCoordinates(as->renderer, event);
+            bool wasScrubbing = as->replay.scrubbing;
+            if (event->type == SDL_EVENT_MOUSE_BUTTON_DOWN) {
+                float x = event->button.x;
+                float y = event->button.y;
+                as->replay.scrubbing = y >= REPLAY_BAR.y - 8.0f && y <= REPLAY_BAR.y + REPLAY_BAR.h + 8.0f;
+                if (as->replay.scrubbing) {
+                    ScrubReplay(as, x);
+                }
+            } else if (event->type == SDL_EVENT_MOUSE_MOTION) {
+                if (as->replay.scrubbing) {
+                    ScrubReplay(as, event->motion.x);
+                }
+            } else {
+                as->replay.scrubbing = false;
+                as->replay.last_ns = SDL_GetTicksNS();  // resume playback from the release
+            }
+            if (as->replay.scrubbing || wasScrubbing) {
+                RequestRedraw(as);
+            }
+            break;
+        }
         case SDL_EVENT_KEY_DOWN: {
             // Handle arrow key presses for tile movement
             AppState *as = (AppState *)appstate;
             SDL_Keycode key = event->key.key;
             
-            Grid::Direction dir;
-            bool validKey = false;
+            // F3 shows / hides the performance overlay (also in replays)
+            if (key == SDLK_F3) {
+                as->overlay.toggle();
+                EnableAllocationCounting();  // off until someone looks (counts from here on)
+                RequestRedraw(as);
+                break;
+            }
+            
+            // Tournament: Up / Down double / halve the speed of every game
+            if (as->spectator.active) {
+                Tournament& tournament = as->spectator.tournament;
+                if (key == SDLK_UP) {
+                    tournament.setSpeed(SDL_min(tournament.getSpeed() * 2, TOURNAMENT_MAX_SPEED));
+                } else if (key == SDLK_DOWN) {
+                    tournament.setSpeed(SDL_max(tournament.getSpeed() / 2, TOURNAMENT_MIN_SPEED));
+                }
+                break;
+            }
+            
+            // Replays use the keys for playback control instead
+            if (as->replay.active) {
+                HandleReplayKey(as, key);
+                RequestRedraw(as);
+                break;
+            }
+            
+            // Held keys repeat through the --key-repeat policy, not one move per OS repeat
+            if (event->key.repeat && !AcceptKeyRepeat(as)) {
+                break;
+            }
+            
+            // Everything else is sent to the game thread, which applies it right away
+            // (up to 64 commands are buffered, so fast players never wait for an animation)
+            GameCommand command;
+            command.direction = Grid::UP;
+            command.timing = MoveTimestamps{};
+            command.timing.keyNs = event->key.timestamp;
+            bool validKey = true;
             
             switch(key) {
             case SDLK_UP:
-                dir = Grid::UP;
-                validKey = true;
+                command.type = GameCommand::MOVE;
+                command.direction = Grid::UP;
                 break;
             case SDLK_DOWN:
-                dir = Grid::DOWN;
-                validKey = true;
+                command.type = GameCommand::MOVE;
+                command.direction = Grid::DOWN;
                 break;
             case SDLK_LEFT: 
-                dir = Grid::LEFT;
-                validKey = true;
+                command.type = GameCommand::MOVE;
+                command.direction = Grid::LEFT;
                 break;
             case SDLK_RIGHT: 
-                dir = Grid::RIGHT;
-                validKey = true;
+                command.type = GameCommand::MOVE;
+                command.direction = Grid::RIGHT;
+                break;
+            case SDLK_Z:
+                // Undo one turn (Shift+Z redoes)
+                command.type = (event->key.mod & SDL_KMOD_SHIFT) ? GameCommand::REDO : GameCommand::UNDO;
+                break;
+            case SDLK_Y:
+                // Redo one undone turn
+                command.type = GameCommand::REDO;
                 break;
             case SDLK_R:
-                // Restart the game
-                as->game_ctx.grid.restart();
-                as->game_ctx.score = 0;
-                // Keep high_score - don't reset it
-                InitGame(as);  // Spawn initial tiles
+                // Restart the game (keeps high_score), saving the finished one first
+                command.type = GameCommand::RESTART;
                 break;
             default:
                 // Unknown key - do nothing, don't log every key press
+                validKey = false;
                 break;
             }
             
+            command.timing.postedNs = SDL_GetTicksNS();
+            if (validKey && !as->game_thread.post(command)) {
+                SDL_Log("Too many moves queued, dropping a key press");
+            }
             if (validKey) {
-                int mergeScore = 0;
-                bool moved = as->game_ctx.grid.orderTilesAndMerge(dir, mergeScore);
-                
-                if (moved) {
-                    // Update score with merge points
-                    as->game_ctx.score += mergeScore;
-                    
-                    // Update high score if needed
-                    if (as->game_ctx.score > as->game_ctx.high_score) {
-                        as->game_ctx.high_score = as->game_ctx.score;
-                    }
-                    
-                    // Spawn a new tile (90% chance of 2, 10% chance of 4)
-                    int newTileValue = (rand() % 10 == 0) ? 4 : 2;
-                    as->game_ctx.grid.spawnRandomTile(newTileValue);
-                }
+                as->last_command_ns = command.timing.postedNs;
             }
             break;
         }
@@ -746,13 +1364,34 @@ void SDL_AppQuit(void *appstate, SDL_AppResult result)
 {
     if (appstate != NULL) {
         AppState *as = (AppState *)appstate;
+        as->game_thread.stop();  // also saves the recording and the session
+        as->spectator.tournament.stop();
+        if (as->print_latency) {
+            as->latency.print(stdout);
+        }
+        if (as->alloc_report) {
+            PrintAllocationReport(as);
+        }
+#ifdef GAME2048_TRACE
+        // The game thread and the tournament are stopped, so their rings hold still
+        std::string traceError;
+        if (as->trace_path && !TraceWrite(as->trace_path, &traceError)) {
+            SDL_Log("Couldn't write the trace: %s", traceError.c_str());
+        }
+#endif
+        as->atlas.destroy();
+        as->background_layer.destroy();
+        as->hud_layer.destroy();
         if (as->renderer) {
             SDL_DestroyRenderer(as->renderer);
         }
         if (as->window) {
             SDL_DestroyWindow(as->window);
         }
-        SDL_free(as);
+        if (as->headless_surface) {
+            SDL_DestroySurface(as->headless_surface);
+        }
+        delete as;  // the threads are stopped, so the members can be destroyed
     }
     // SDL_Quit() will be called automatically by SDL, but it's safe to call it here too
     SDL_Quit();
@@ -0,0 +1,107 @@
+#include "perf_overlay.h"
+#include "text.h"
+#include <algorithm>
+#include <cstdio>     // for snprintf
+
+void PerfOverlay::recordFrame(Uint64 frameNs, int drawCalls, int vertices, Uint64 allocations, Uint64 allocatedBytes) {
+    if (frameNs > 0) {
+        frameTimes[nextFrame] = frameNs;
+        nextFrame = (nextFrame + 1) % FRAME_HISTORY;
+        frameCount = std::min(frameCount + 1, FRAME_HISTORY);
+    }
+    lastDrawCalls = drawCalls;
+    lastVertices = vertices;
+    lastAllocations = allocations;
+    lastAllocatedBytes = allocatedBytes;
+}
+
+void PerfOverlay::recordMoveAllocations(Uint64 allocations, Uint64 allocatedBytes) {
+    moveAllocations = allocations;
+    moveAllocatedBytes = allocatedBytes;
+    moveAllocationsSeen = true;
+}
+
+void PerfOverlay::recordMoveLatency(Uint64 latencyNs) {
+    moveLatencies[nextMove] = latencyNs;
+    nextMove = (nextMove + 1) % MOVE_HISTORY;
+    moveCount = std::min(moveCount + 1, MOVE_HISTORY);
+}
+
+double PerfOverlay::frameTimePercentile(int count, double p) {
+    // Nearest rank; sorted[] already holds the frame times
+    int rank = (int)(p / 100.0 * (count - 1) + 0.5);
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.begin() + count);
+    return sorted[rank] / 1e6;
+}
+
+void PerfOverlay::draw(FrameBuilder& frame, const TextureAtlas& atlas) {
+    debugTextPending = false;
+    if (!visible) {
+        return;
+    }
+
+    lineCount = 5;
+    if (frameCount > 0) {
+        std::copy(frameTimes.begin(), frameTimes.begin() + frameCount, sorted.begin());
+        double p50 = frameTimePercentile(frameCount, 50.0);
+        double p95 = frameTimePercentile(frameCount, 95.0);
+        double p99 = frameTimePercentile(frameCount, 99.0);
+        snprintf(lines[0], sizeof(lines[0]), "ms %.1f %.1f %.1f", p50, p95, p99);
+    } else {
+        snprintf(lines[0], sizeof(lines[0]), "ms -");
+    }
+    snprintf(lines[1], sizeof(lines[1]), "draws %d verts %d", lastDrawCalls, lastVertices);
+    snprintf(lines[2], sizeof(lines[2]), "allocs %llu %lluB", (unsigned long long)lastAllocations,
+             (unsigned long long)lastAllocatedBytes);
+    if (moveCount > 0) {
+        Uint64 total = 0;
+        Uint64 worst = 0;
+        for (int i = 0; i < moveCount; i++) {
+            total += moveLatencies[i];
+            worst = std::max(worst, moveLatencies[i]);
+        }
+        snprintf(lines[3], sizeof(lines[3]), "move %.2f max %.2f", total / 1e6 / moveCount, worst / 1e6);
+    } else {
+        snprintf(lines[3], sizeof(lines[3]), "move -");
+    }
+    if (moveAllocationsSeen) {
+        snprintf(lines[4], sizeof(lines[4]), "move allocs %llu %lluB", (unsigned long long)moveAllocations,
+                 (unsigned long long)moveAllocatedBytes);
+    } else {
+        snprintf(lines[4], sizeof(lines[4]), "move allocs -");
+    }
+    if (searchSpeed > 0.0) {
+        snprintf(lines[5], sizeof(lines[5]), "ai nps %.0f", searchSpeed);
+        lineCount = 6;
+    }
+
+    // Light panel so the text stays readable over the tiles
+    lineHeight = GetScaledTextHeight() + 6.0f;
+    float width = 0.0f;
+    for (int i = 0; i < lineCount; i++) {
+        width = std::max(width, GetScaledTextWidth(lines[i]));
+    }
+    SDL_FRect panel = { 4.0f, 4.0f, width + 12.0f, lineHeight * lineCount + 6.0f };
+    frame.addRect(panel, MakeColor(250, 248, 239, 220));
+    textX = panel.x + 6.0f;
+    textY = panel.y + 6.0f;
+    if (!atlas.isReady()) {
+        // Text quads without the atlas texture would come out as white boxes
+        debugTextPending = true;
+        return;
+    }
+    for (int i = 0; i < lineCount; i++) {
+        atlas.addText(frame, textX, textY + i * lineHeight, lines[i]);
+    }
+}
+
+void PerfOverlay::drawDebugText(SDL_Renderer* renderer) {
+    if (!debugTextPending) {
+        return;
+    }
+    debugTextPending = false;
+    SDL_SetRenderDrawColor(renderer, 119, 110, 101, 255);  // Dark gray, like the HUD fallback
+    for (int i = 0; i < lineCount; i++) {
+        RenderScaledText(renderer, textX, textY + i * lineHeight, lines[i]);
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "atlas.h"
+#include "frame_builder.h"
+#include <array>
+
+// PerfOverlay - frame time, draw and allocation statistics drawn over the game
+// Statistics are recorded every frame into fixed-size rings (a few stores
+// per frame). Percentiles are only worked out while the overlay is shown,
+// in a preallocated scratch array, so showing it doesn't allocate either.
+class PerfOverlay {
+public:
+    static const int FRAME_HISTORY = 240;  // frames the percentiles are taken over
+    static const int MOVE_HISTORY = 64;    // moves the latency is taken over
+
+    void toggle() { visible = !visible; }
+    bool isVisible() const { return visible; }
+
+    // Call after each SDL_RenderPresent. frameNs is the time since the
+    // previous present, 0 if the app was idle in between (not counted).
+    // allocations and allocatedBytes: made since the previous present
+    void recordFrame(Uint64 frameNs, int drawCalls, int vertices, Uint64 allocations, Uint64 allocatedBytes);
+
+    // Allocations made applying the newest move
+    void recordMoveAllocations(Uint64 allocations, Uint64 allocatedBytes);
+
+    // Time from the key press to the first frame showing the move
+    void recordMoveLatency(Uint64 latencyNs);
+
+    // Search speed of the AI players, shown while it is above 0
+    void setSearchSpeed(double nodesPerSecond) { searchSpeed = nodesPerSecond; }
+
+    // Add the overlay (background and text) to the frame, top left
+    // Without a ready atlas only the background is added; call drawDebugText
+    // after submitting the frame to put the text on top of it
+    void draw(FrameBuilder& frame, const TextureAtlas& atlas);
+
+    // Draw the text left out by the last draw() with SDL_RenderDebugText
+    void drawDebugText(SDL_Renderer* renderer);
+
+private:
+    // p-th percentile (0-100) of the recorded frame times, in milliseconds
+    double frameTimePercentile(int count, double p);
+
+    bool visible = false;
+
+    // Text of the last draw(), kept for drawDebugText
+    char lines[6][48] = {};
+    int lineCount = 0;
+    float textX = 0.0f;
+    float textY = 0.0f;
+    float lineHeight = 0.0f;
+    bool debugTextPending = false;
+
+    std::array<Uint64, FRAME_HISTORY> frameTimes = {};
+    int frameCount = 0;   // valid entries (up to FRAME_HISTORY)
+    int nextFrame = 0;    // ring position for the next entry
+    std::array<Uint64, FRAME_HISTORY> sorted = {};  // scratch for the percentiles
+
+    std::array<Uint64, MOVE_HISTORY> moveLatencies = {};
+    int moveCount = 0;
+    int nextMove = 0;
+
+    int lastDrawCalls = 0;
+    int lastVertices = 0;
+    Uint64 lastAllocations = 0;
+    Uint64 lastAllocatedBytes = 0;
+    Uint64 moveAllocations = 0;
+    Uint64 moveAllocatedBytes = 0;
+    bool moveAllocationsSeen = false;
+    double searchSpeed = 0.0;
+};
@@ -0,0 +1,258 @@
+// game2048-perft - counts every (move, spawn) sequence from a position
+//
+// Usage: game2048-perft [-j threads] [--grid] [--divide] <depth> [16 tile values]
+//        game2048-perft --verify [-j threads]
+//
+// Like perft in chess engines: the number of positions reached after exactly
+// <depth> turns, where a turn is one of the moves that change the board
+// followed by a 2 or a 4 spawning in one of the empty cells. Positions where
+// no move is possible before <depth> add nothing. Without tile values the
+// board starts with a 2 in the top left and bottom right corners.
+//
+// The count checks a move generator: the default engine is the solver's Board
+// (bitboard.h), --grid uses Grid::orderTilesAndMerge (the game itself), and
+// both must agree. --divide prints the count below each first move, to
+// narrow down a difference. --verify runs both engines on the reference
+// positions below and exits with 1 on any wrong count.
+// The turns below the root are spread over -j threads (default: all cores).
+#include "bitboard.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+static const char* DIRECTION_NAMES[4] = { "up", "down", "left", "right" };
+
+// Reference counts (checked with both engines), row by row, 0 = empty
+struct PerftReference {
+    const char* name;
+    int tiles[BOARD_CELLS];
+    int depth;
+    Uint64 count;
+};
+
+static const PerftReference REFERENCES[] = {
+    { "corners", { 2, 0, 0, 0,  0, 0, 0, 0,  0, 0, 0, 0,  0, 0, 0, 2 }, 1, 112 },
+    { "corners", { 2, 0, 0, 0,  0, 0, 0, 0,  0, 0, 0, 0,  0, 0, 0, 2 }, 2, 11536 },
+    { "corners", { 2, 0, 0, 0,  0, 0, 0, 0,  0, 0, 0, 0,  0, 0, 0, 2 }, 3, 1124032 },
+    { "merges",  { 2, 2, 4, 4,  8, 8, 16, 16,  0, 0, 0, 0,  0, 0, 0, 0 }, 3, 332616 },
+    { "mid",     { 2, 4, 8, 16,  4, 8, 16, 32,  0, 2, 0, 4,  0, 0, 0, 2 }, 3, 36450 },
+    { "full",    { 2, 4, 2, 4,  4, 2, 4, 2,  2, 4, 2, 4,  4, 2, 4, 0 }, 4, 55704 },
+    { "stuck",   { 2, 4, 2, 4,  4, 2, 4, 2,  2, 4, 2, 4,  4, 2, 4, 2 }, 1, 0 },
+};
+
+// One turn below the root, counted as its own task
+struct RootTurn {
+    int direction;
+    Board board;      // after the move and the spawn (Board engine)
+    Grid grid;        // the same position (Grid engine)
+};
+
+static Uint64 PerftBoard(Board board, int depth) {
+    if (depth == 0) {
+        return 1;
+    }
+    Uint64 count = 0;
+    for (int dir = 0; dir < 4; dir++) {
+        Board moved = BoardMove(board, (Grid::Direction)dir);
+        if (moved == board) {
+            continue;
+        }
+        for (int cell = 0; cell < BOARD_CELLS; cell++) {
+            if (BoardGetExponent(moved, cell) != 0) {
+                continue;
+            }
+            if (depth == 1) {
+                count += 2;  // both spawns are leaves
+                continue;
+            }
+            count += PerftBoard(BoardSetExponent(moved, cell, 1), depth - 1);
+            count += PerftBoard(BoardSetExponent(moved, cell, 2), depth - 1);
+        }
+    }
+    return count;
+}
+
+static Uint64 PerftGrid(const Grid& grid, int depth) {
+    if (depth == 0) {
+        return 1;
+    }
+    Uint64 count = 0;
+    Grid moved = grid;
+    for (int dir = 0; dir < 4; dir++) {
+        moved = grid;
+        int score = 0;
+        if (!moved.orderTilesAndMerge((Grid::Direction)dir, score)) {
+            continue;
+        }
+        for (int cell = 0; cell < (int)moved.size(); cell++) {
+            if (!moved.at(cell).isEmpty()) {
+                continue;
+            }
+            for (int value = 2; value <= 4; value += 2) {
+                moved.at(cell).value = value;
+                count += PerftGrid(moved, depth - 1);
+            }
+            moved.at(cell).value = 0;
+        }
+    }
+    return count;
+}
+
+// All first turns (move + spawn) of a position
+static std::vector<RootTurn> RootTurns(const Grid& grid) {
+    std::vector<RootTurn> turns;
+    for (int dir = 0; dir < 4; dir++) {
+        Grid moved = grid;
+        int score = 0;
+        if (!moved.orderTilesAndMerge((Grid::Direction)dir, score)) {
+            continue;
+        }
+        for (int cell = 0; cell < (int)moved.size(); cell++) {
+            if (!moved.at(cell).isEmpty()) {
+                continue;
+            }
+            for (int value = 2; value <= 4; value += 2) {
+                RootTurn turn{ dir, 0, moved };
+                turn.grid.at(cell).value = value;
+                BoardFromGrid(turn.grid, turn.board);
+                turns.push_back(turn);
+            }
+        }
+    }
+    return turns;
+}
+
+// Count to `depth`; counts[d] gets the total below each direction d (for --divide)
+static Uint64 Perft(ThreadPool& pool, const Grid& grid, int depth, bool useGrid, Uint64 counts[4]) {
+    std::fill(counts, counts + 4, 0);
+    if (depth == 0) {
+        return 1;
+    }
+    std::vector<RootTurn> turns = RootTurns(grid);
+    std::vector<Uint64> results(turns.size());
+    std::vector<std::function<void()>> batch;
+    for (size_t i = 0; i < turns.size(); i++) {
+        batch.push_back([&, i]() {
+            results[i] = useGrid ? PerftGrid(turns[i].grid, depth - 1) : PerftBoard(turns[i].board, depth - 1);
+        });
+    }
+    pool.run(batch);
+
+    Uint64 total = 0;
+    for (size_t i = 0; i < turns.size(); i++) {
+        counts[turns[i].direction] += results[i];
+        total += results[i];
+    }
+    return total;
+}
+
+static Grid MakeGrid(const int* tiles) {
+    Grid grid(GRID_ROWS, GRID_COLS, GRID_WIDTH, GRID_HEIGHT);
+    for (int i = 0; i < BOARD_CELLS; i++) {
+        grid.at(i).value = tiles[i];
+    }
+    return grid;
+}
+
+// Run both engines on every reference position
+static bool Verify(ThreadPool& pool) {
+    bool ok = true;
+    for (const PerftReference& reference : REFERENCES) {
+        Grid grid = MakeGrid(reference.tiles);
+        Uint64 counts[4];
+        Uint64 board = Perft(pool, grid, reference.depth, false, counts);
+        Uint64 game = Perft(pool, grid, reference.depth, true, counts);
+        bool match = board == reference.count && game == reference.count;
+        printf("%s  %-8s depth %d: expected %llu, board %llu, grid %llu\n", match ? "OK  " : "FAIL",
+               reference.name, reference.depth, (unsigned long long)reference.count,
+               (unsigned long long)board, (unsigned long long)game);
+        ok = ok && match;
+    }
+    return ok;
+}
+
+static void PrintUsage(FILE* out, const char* program) {
+    fprintf(out, "Usage: %s [-j threads] [--grid] [--divide] <depth> [16 tile values]\n"
+                 "       %s --verify [-j threads]\n", program, program);
+}
+
+// Parse a whole argument as a decimal number; false for anything else
+// (a typo or an unknown flag must not quietly run depth 0)
+static bool ParseNumber(const char* text, int& value) {
+    char* end = NULL;
+    long number = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || number < -1000000 || number > 1000000) {
+        return false;
+    }
+    value = (int)number;
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int threadCount = 0;
+    bool useGrid = false;
+    bool divide = false;
+    bool verify = false;
+    std::vector<int> numbers;
+    for (int i = 1; i < argc; i++) {
+        int number = 0;
+        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            PrintUsage(stdout, argv[0]);
+            return 0;
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            if (!ParseNumber(argv[++i], threadCount) || threadCount < 0) {
+                fprintf(stderr, "-j needs a number of threads, not '%s'\n", argv[i]);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--grid") == 0) {
+            useGrid = true;
+        } else if (strcmp(argv[i], "--divide") == 0) {
+            divide = true;
+        } else if (strcmp(argv[i], "--verify") == 0) {
+            verify = true;
+        } else if (ParseNumber(argv[i], number)) {
+            numbers.push_back(number);
+        } else {
+            fprintf(stderr, "Unknown argument '%s'\n", argv[i]);
+            PrintUsage(stderr, argv[0]);
+            return 2;
+        }
+    }
+    if (!verify && numbers.size() != 1 && numbers.size() != 1 + BOARD_CELLS) {
+        PrintUsage(stderr, argv[0]);
+        return 2;
+    }
+    ThreadPool pool(threadCount);
+    if (verify) {
+        return Verify(pool) ? 0 : 1;
+    }
+
+    int depth = std::max(numbers[0], 0);
+    int corners[BOARD_CELLS] = { 2, 0, 0, 0,  0, 0, 0, 0,  0, 0, 0, 0,  0, 0, 0, 2 };
+    Grid grid = MakeGrid(numbers.size() > 1 ? &numbers[1] : corners);
+    Board check;
+    if (!BoardFromGrid(grid, check)) {
+        fprintf(stderr, "tile values must be 0 or powers of two up to 32768, with at most one 32768\n");
+        return 2;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    Uint64 counts[4];
+    Uint64 total = Perft(pool, grid, depth, useGrid, counts);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (divide) {
+        for (int dir = 0; dir < 4; dir++) {
+            printf("%-6s %llu\n", DIRECTION_NAMES[dir], (unsigned long long)counts[dir]);
+        }
+    }
+    printf("perft %d: %llu positions in %.3f s (%.0f per second, %s engine, %d threads)\n", depth,
+           (unsigned long long)total, seconds, seconds > 0.0 ? total / seconds : 0.0,
+           useGrid ? "grid" : "board", pool.size());
+    return 0;
+}
@@ -0,0 +1,50 @@
+#include "render_layer.h"
+#include <SDL3/SDL_log.h>
+
+bool RenderLayer::begin(SDL_Renderer* renderer, int width, int height, float scale) {
+    valid = false;
+    if (failed) {
+        return false;
+    }
+    int pixelWidth = SDL_max((int)SDL_ceilf(width * scale), 1);
+    int pixelHeight = SDL_max((int)SDL_ceilf(height * scale), 1);
+    if (texture && (texture->w != pixelWidth || texture->h != pixelHeight)) {
+        destroy();
+    }
+    if (!texture) {
+        texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, pixelWidth, pixelHeight);
+        if (!texture) {
+            SDL_Log("Couldn't create render layer, drawing directly: %s", SDL_GetError());
+            failed = true;
+            return false;
+        }
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    }
+
+    oldTarget = SDL_GetRenderTarget(renderer);
+    if (!SDL_SetRenderTarget(renderer, texture)) {
+        SDL_Log("Couldn't render to render layer, drawing directly: %s", SDL_GetError());
+        destroy();
+        failed = true;
+        return false;
+    }
+    // Draw in logical units; every texture target keeps its own scale
+    SDL_SetRenderScale(renderer, (float)pixelWidth / width, (float)pixelHeight / height);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+    SDL_RenderClear(renderer);
+    return true;
+}
+
+void RenderLayer::end(SDL_Renderer* renderer) {
+    SDL_SetRenderTarget(renderer, oldTarget);
+    oldTarget = NULL;
+    valid = true;
+}
+
+void RenderLayer::destroy() {
+    if (texture) {
+        SDL_DestroyTexture(texture);
+        texture = NULL;
+    }
+    valid = false;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <SDL3/SDL_render.h>
+
+// RenderLayer - a cached part of the screen kept in a render-target texture
+// Draw the layer's contents once between begin() and end(); after that the
+// whole layer is put on screen with a single textured quad until it is
+// invalidated (its contents changed, the window was resized or the renderer
+// lost its textures). The texture is transparent where nothing was drawn.
+class RenderLayer {
+public:
+    // Make the layer the render target, (re)creating its texture if the size
+    // changed, and clear it. width and height are in logical units; the texture
+    // has scale pixels per unit (the window's pixels per logical pixel) and is
+    // drawn into with that render scale, so the layer stays as sharp as the
+    // rest of the screen. Returns false if the renderer can't render to
+    // textures; callers then draw the contents directly every frame
+    bool begin(SDL_Renderer* renderer, int width, int height, float scale = 1.0f);
+
+    // Switch back to the previous render target and mark the layer valid
+    void end(SDL_Renderer* renderer);
+
+    void invalidate() { valid = false; }
+    bool isValid() const { return valid; }
+    SDL_Texture* getTexture() const { return texture; }
+
+    // The whole texture, in its pixels (the source rectangle for drawing it)
+    SDL_FRect getTextureRect() const { return SDL_FRect{ 0.0f, 0.0f, (float)texture->w, (float)texture->h }; }
+    void destroy();
+
+private:
+    SDL_Texture* texture = NULL;
+    SDL_Texture* oldTarget = NULL;
+    bool valid = false;
+    bool failed = false;  // render targets don't work here, don't keep trying
+};
@@ -0,0 +1,195 @@
+#include "replay.h"
+#include "binary_io.h"
+#include "error.h"
+#include <cstdio>
+#include <cstring>
+
+static const char REPLAY_MAGIC[8] = { '2', '0', '4', '8', 'R', 'P', 'L', '1' };
+
+Replay ReplayFromGame(const GameContext& ctx) {
+    Replay replay;
+    replay.rows = ctx.grid.getRows();
+    replay.cols = ctx.grid.getCols();
+    replay.seed = ctx.seed;
+    replay.finalScore = ctx.score;
+    replay.turns = ctx.turns;
+    return replay;
+}
+
+bool SaveReplay(const char* path, const Replay& replay, std::string* error) {
+    std::vector<Uint8> data;
+    data.reserve(28 + replay.turns.size() * 4);
+    data.insert(data.end(), REPLAY_MAGIC, REPLAY_MAGIC + sizeof(REPLAY_MAGIC));
+    PutU16(data, (Uint16)replay.rows);
+    PutU16(data, (Uint16)replay.cols);
+    PutU64(data, replay.seed);
+    PutU32(data, (Uint32)replay.finalScore);
+    PutU32(data, (Uint32)replay.turns.size());
+    for (const TurnRecord& turn : replay.turns) {
+        data.push_back(turn.direction);
+        data.push_back(turn.spawnExponent);
+        PutU16(data, turn.spawnCell);
+    }
+
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        return Fail(error, std::string("can't open ") + path + " for writing");
+    }
+    bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+    ok = (fclose(file) == 0) && ok;
+    if (!ok) {
+        return Fail(error, std::string("can't write ") + path);
+    }
+    return true;
+}
+
+bool LoadReplay(const char* path, Replay& replay, std::string* error) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return Fail(error, std::string("can't open ") + path);
+    }
+    std::vector<Uint8> data;
+    Uint8 buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.insert(data.end(), buffer, buffer + n);
+    }
+    fclose(file);
+
+    const size_t headerSize = 28;
+    if (data.size() < headerSize || memcmp(data.data(), REPLAY_MAGIC, sizeof(REPLAY_MAGIC)) != 0) {
+        return Fail(error, std::string(path) + " is not a 2048 replay");
+    }
+    const Uint8* p = data.data() + sizeof(REPLAY_MAGIC);
+    replay.rows = (int)GetLE(p, 2);
+    replay.cols = (int)GetLE(p + 2, 2);
+    replay.seed = GetLE(p + 4, 8);
+    replay.finalScore = (int)GetLE(p + 12, 4);
+    Uint32 turnCount = (Uint32)GetLE(p + 16, 4);
+    if (data.size() != headerSize + (size_t)turnCount * 4) {
+        return Fail(error, std::string(path) + " is truncated");
+    }
+
+    replay.turns.resize(turnCount);
+    p = data.data() + headerSize;
+    for (Uint32 i = 0; i < turnCount; i++, p += 4) {
+        replay.turns[i].direction = p[0];
+        replay.turns[i].spawnExponent = p[1];
+        replay.turns[i].spawnCell = (Uint16)GetLE(p + 2, 2);
+        if (!IsValidTurnRecord(replay.turns[i])) {
+            return Fail(error, std::string(path) + ": turn " + std::to_string(i + 1) + " has direction " +
+                        std::to_string(p[0]) + " and spawn exponent " + std::to_string(p[1]) +
+                        " (expected 0-3 and 0-2)");
+        }
+    }
+    return true;
+}
+
+bool ApplyRecordedTurn(Grid& grid, int& score, const TurnRecord& turn) {
+    if (!IsValidTurnRecord(turn)) {
+        return false;
+    }
+    int mergeScore = 0;
+    if (!grid.orderTilesAndMerge((Grid::Direction)turn.direction, mergeScore)) {
+        return false;
+    }
+    score += mergeScore;
+
+    if (turn.spawnExponent != 0) {
+        if (turn.spawnCell >= grid.size() || !grid.at(turn.spawnCell).isEmpty()) {
+            return false;
+        }
+        grid.at(turn.spawnCell).value = 1 << turn.spawnExponent;
+    }
+    return true;
+}
+
+bool VerifyReplay(const Replay& replay, std::string* error) {
+    GameContext ctx;
+    if (replay.rows != ctx.grid.getRows() || replay.cols != ctx.grid.getCols()) {
+        return Fail(error, "replay was recorded on a different grid size");
+    }
+
+    NewGame(ctx, replay.seed);
+    ctx.turns.reserve(replay.turns.size());
+    for (size_t i = 0; i < replay.turns.size(); i++) {
+        const TurnRecord& recorded = replay.turns[i];
+        auto where = [i]() { return "turn " + std::to_string(i + 1) + ": "; };
+        // Before any shift by the recorded exponent
+        if (!IsValidTurnRecord(recorded)) {
+            return Fail(error, where() + "invalid direction " + std::to_string(recorded.direction) +
+                " or spawn exponent " + std::to_string(recorded.spawnExponent));
+        }
+        if (!PlayTurn(ctx, (Grid::Direction)recorded.direction)) {
+            return Fail(error, where() + "move does not change the board");
+        }
+        const TurnRecord& played = ctx.turns.back();
+        if (played.spawnCell != recorded.spawnCell || played.spawnExponent != recorded.spawnExponent) {
+            return Fail(error, where() + "spawned " + std::to_string(1 << recorded.spawnExponent) +
+                " at cell " + std::to_string(recorded.spawnCell) + ", seed gives " +
+                std::to_string(1 << played.spawnExponent) + " at cell " + std::to_string(played.spawnCell));
+        }
+    }
+    if (ctx.score != replay.finalScore) {
+        return Fail(error, "final score " + std::to_string(ctx.score) + " does not match claimed " +
+            std::to_string(replay.finalScore));
+    }
+    return true;
+}
+
+bool ReplayPlayer::load(const Replay& source, GameContext& ctx, std::string* error) {
+    if (source.rows != ctx.grid.getRows() || source.cols != ctx.grid.getCols()) {
+        return Fail(error, "replay was recorded on a different grid size");
+    }
+    replay = source;
+    keyframes.clear();
+
+    // Play the whole game once, remembering a keyframe every KEYFRAME_INTERVAL turns
+    NewGame(ctx, replay.seed);
+    ctx.high_score = replay.finalScore;
+    for (int i = 0; ; i++) {
+        if (i % KEYFRAME_INTERVAL == 0) {
+            Keyframe keyframe;
+            keyframe.values.reserve(ctx.grid.size());
+            for (const Tile& tile : ctx.grid) {
+                keyframe.values.push_back(tile.value);
+            }
+            keyframe.score = ctx.score;
+            keyframes.push_back(std::move(keyframe));
+        }
+        if (i == length()) {
+            break;
+        }
+        if (!ApplyRecordedTurn(ctx.grid, ctx.score, replay.turns[i])) {
+            return Fail(error, "replay has an illegal turn " + std::to_string(i + 1));
+        }
+    }
+
+    current = length();
+    seek(0, ctx);
+    return true;
+}
+
+void ReplayPlayer::restoreKeyframe(int index, GameContext& ctx) const {
+    const Keyframe& keyframe = keyframes[index];
+    for (size_t i = 0; i < keyframe.values.size(); i++) {
+        ctx.grid.at((int)i).value = keyframe.values[i];
+    }
+    ctx.score = keyframe.score;
+}
+
+void ReplayPlayer::seek(int turn, GameContext& ctx) {
+    turn = std::clamp(turn, 0, length());
+
+    // Going forward within the same keyframe span: just keep playing
+    // Otherwise jump to the nearest keyframe at or before the target
+    int keyframe = turn / KEYFRAME_INTERVAL;
+    if (turn < current || current < keyframe * KEYFRAME_INTERVAL) {
+        restoreKeyframe(keyframe, ctx);
+        current = keyframe * KEYFRAME_INTERVAL;
+    }
+    while (current < turn) {
+        ApplyRecordedTurn(ctx.grid, ctx.score, replay.turns[current]);
+        current++;
+    }
+}
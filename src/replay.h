@@ -0,0 +1,73 @@
+#pragma once
+
+#include "game.h"
+#include <string>
+#include <vector>
+
+// Replay - everything needed to reproduce a game
+// File layout (all integers little-endian):
+//   "2048RPL1"  magic
+//   u16 rows, u16 cols
+//   u64 seed
+//   u32 final score (the score the game claims to have reached)
+//   u32 turn count
+//   turn count x { u8 direction, u8 spawn exponent, u16 spawn cell }
+struct Replay {
+    int rows = GRID_ROWS;
+    int cols = GRID_COLS;
+    Uint64 seed = 0;
+    int finalScore = 0;
+    std::vector<TurnRecord> turns;
+};
+
+// Build a replay from the game currently held by ctx
+Replay ReplayFromGame(const GameContext& ctx);
+
+// Read / write replay files. On failure return false and describe the
+// problem in error (if given)
+bool SaveReplay(const char* path, const Replay& replay, std::string* error = nullptr);
+bool LoadReplay(const char* path, Replay& replay, std::string* error = nullptr);
+
+// Apply a recorded turn without using the random number generator:
+// move the tiles, add the merge score and place the recorded spawn
+// Returns false if the turn is invalid (IsValidTurnRecord), the move does not
+// change the grid or the spawn cell is occupied
+bool ApplyRecordedTurn(Grid& grid, int& score, const TurnRecord& turn);
+
+// Re-play a replay from its seed with the normal game rules and random
+// number generator. Stops at the first turn that differs from the recording
+// (a move that changes nothing, or a different spawn) and reports it in error,
+// and also fails if the final score is not the claimed one
+bool VerifyReplay(const Replay& replay, std::string* error = nullptr);
+
+// ReplayPlayer - seekable playback of a replay into a GameContext
+// Full-board keyframes are stored every KEYFRAME_INTERVAL turns, so seeking
+// to any turn restores the nearest earlier keyframe and re-applies at most
+// KEYFRAME_INTERVAL - 1 turns
+class ReplayPlayer {
+public:
+    static const int KEYFRAME_INTERVAL = 256;
+
+    // Load a replay and build its keyframes. Returns false if the replay
+    // does not match the grid size or contains an illegal turn
+    bool load(const Replay& replay, GameContext& ctx, std::string* error = nullptr);
+
+    // Move ctx to the state right after `turn` turns have been played
+    void seek(int turn, GameContext& ctx);
+
+    int position() const { return current; }
+    int length() const { return (int)replay.turns.size(); }
+    const Replay& getReplay() const { return replay; }
+
+private:
+    struct Keyframe {
+        std::vector<int> values;
+        int score;
+    };
+
+    void restoreKeyframe(int index, GameContext& ctx) const;
+
+    Replay replay;
+    std::vector<Keyframe> keyframes;  // keyframes[i] is the state after i * KEYFRAME_INTERVAL turns
+    int current = 0;
+};
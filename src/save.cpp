@@ -0,0 +1,274 @@
+#include "save.h"
+#include "binary_io.h"
+#include <SDL3/SDL_filesystem.h>
+#include <SDL3/SDL_iostream.h>
+#include <SDL3/SDL_log.h>
+#include <cstring>
+
+static const char SESSION_MAGIC[8] = { '2', '0', '4', '8', 'S', 'A', 'V', '2' };
+static const char* SESSION_FILE = "session.sav";
+static const char* TURN_LOG_FILE = "session.turns";
+static const size_t SESSION_HEADER_SIZE = 36;  // magic up to and including rows/cols
+
+std::vector<Uint8> SerializeSession(const GameContext& ctx) {
+    std::vector<Uint8> data;
+    data.reserve(SESSION_HEADER_SIZE + ctx.grid.size() * 4 + 4);
+    PutBytes(data, SESSION_MAGIC, sizeof(SESSION_MAGIC));
+    PutU32(data, (Uint32)ctx.high_score);
+    PutU32(data, (Uint32)ctx.score);
+    PutU64(data, ctx.seed);
+    PutU64(data, ctx.rng.state);
+    PutU16(data, (Uint16)ctx.grid.getRows());
+    PutU16(data, (Uint16)ctx.grid.getCols());
+    for (const Tile& tile : ctx.grid) {
+        PutU32(data, (Uint32)tile.value);
+    }
+    PutU32(data, (Uint32)ctx.turns.size());
+    return data;
+}
+
+std::vector<Uint8> SerializeTurns(const GameContext& ctx, size_t first) {
+    std::vector<Uint8> data;
+    if (first >= ctx.turns.size()) {
+        return data;
+    }
+    data.reserve((ctx.turns.size() - first) * 4);
+    for (size_t i = first; i < ctx.turns.size(); i++) {
+        const TurnRecord& turn = ctx.turns[i];
+        data.push_back(turn.direction);
+        data.push_back(turn.spawnExponent);
+        PutU16(data, turn.spawnCell);
+    }
+    return data;
+}
+
+bool DeserializeSession(const Uint8* data, size_t size,
+                        const Uint8* log, size_t logSize, GameContext& ctx) {
+    if (size < SESSION_HEADER_SIZE || memcmp(data, SESSION_MAGIC, sizeof(SESSION_MAGIC)) != 0) {
+        return false;
+    }
+    const Uint8* p = data + sizeof(SESSION_MAGIC);
+    int rows = (int)GetLE(p + 24, 2);
+    int cols = (int)GetLE(p + 26, 2);
+    if (rows != ctx.grid.getRows() || cols != ctx.grid.getCols()) {
+        return false;
+    }
+    size_t cells = ctx.grid.size();
+    if (size != SESSION_HEADER_SIZE + cells * 4 + 4) {
+        return false;
+    }
+    const Uint8* tiles = data + SESSION_HEADER_SIZE;
+    Uint32 turnCount = (Uint32)GetLE(tiles + cells * 4, 4);
+    if (logSize / 4 < turnCount) {
+        return false;  // the log is missing turns (e.g. a crash between the two writes)
+    }
+
+    // Play the logged turns from the seed, the same way History rebuilds a
+    // game, and check they lead to exactly the saved board. This catches a log
+    // that is out of step with the session file as well as a corrupt file, and
+    // nothing is taken over into ctx (or later a recording) unless it matches
+    GameContext check = ctx;
+    NewGame(check, GetLE(p + 8, 8));
+    for (Uint32 i = 0; i < turnCount; i++, log += 4) {
+        TurnRecord turn;
+        turn.direction = log[0];
+        turn.spawnExponent = log[1];
+        turn.spawnCell = (Uint16)GetLE(log + 2, 2);
+        if (!IsValidTurnRecord(turn) || !PlayTurn(check, (Grid::Direction)turn.direction)) {
+            return false;
+        }
+        const TurnRecord& played = check.turns.back();
+        if (played.spawnExponent != turn.spawnExponent || played.spawnCell != turn.spawnCell) {
+            return false;
+        }
+    }
+    if (check.score != (int)GetLE(p + 4, 4) || check.rng.state != GetLE(p + 16, 8)) {
+        return false;
+    }
+    for (size_t i = 0; i < cells; i++) {
+        if ((Uint64)check.grid.at((int)i).value != GetLE(tiles + i * 4, 4)) {
+            return false;
+        }
+    }
+
+    check.high_score = (int)GetLE(p, 4);
+    ctx = std::move(check);
+    return true;
+}
+
+bool SessionSaver::init(const char* org, const char* app) {
+    char* prefPath = SDL_GetPrefPath(org, app);
+    if (!prefPath) {
+        SDL_Log("Couldn't find a save location: %s", SDL_GetError());
+        return false;
+    }
+    path = std::string(prefPath) + SESSION_FILE;
+    tempPath = path + ".tmp";
+    logPath = std::string(prefPath) + TURN_LOG_FILE;
+    SDL_free(prefPath);
+
+    queue = SDL_CreateAsyncIOQueue();
+    if (!queue) {
+        SDL_Log("Couldn't create async I/O queue: %s", SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+bool SessionSaver::load(GameContext& ctx) {
+    if (path.empty()) {
+        return false;
+    }
+    size_t size = 0;
+    Uint8* data = (Uint8*)SDL_LoadFile(path.c_str(), &size);
+    if (!data) {
+        return false;  // No previous session
+    }
+    size_t logSize = 0;
+    Uint8* log = (Uint8*)SDL_LoadFile(logPath.c_str(), &logSize);  // none for a game without turns
+    bool ok = DeserializeSession(data, size, log, log ? logSize : 0, ctx);
+    if (ok) {
+        logTurns = ctx.turns.size();
+    } else {
+        SDL_Log("Ignoring unreadable session file %s", path.c_str());
+        // The game is lost, but keep the high score if the header is intact
+        if (size >= SESSION_HEADER_SIZE && memcmp(data, SESSION_MAGIC, sizeof(SESSION_MAGIC)) == 0) {
+            ctx.high_score = (int)GetLE(data + sizeof(SESSION_MAGIC), 4);
+        }
+    }
+    SDL_free(log);
+    SDL_free(data);
+    return ok;
+}
+
+void SessionSaver::save(const GameContext& ctx) {
+    if (!queue) {
+        return;
+    }
+    // Turns from `first` on are not in the log (or not queued for it) yet. After
+    // an undo the log holds turns the game no longer has, and the next move
+    // overwrites them from the current turn count
+    size_t count = ctx.turns.size();
+    size_t first = SDL_min(hasPending ? pendingLogFirst : logTurns, count);
+    pending = SerializeSession(ctx);
+    pendingLog = SerializeTurns(ctx, first);
+    pendingLogFirst = first;
+    logTurns = count;
+    hasPending = true;
+    if (!busy) {
+        startWrite();
+    }
+}
+
+void SessionSaver::startWrite() {
+    writing.swap(pending);
+    writingLog.swap(pendingLog);
+    writingLogFirst = pendingLogFirst;
+    hasPending = false;
+    writeFailed = false;
+    writingSession = false;
+
+    // Nothing new for the log (e.g. after an undo): go straight to the session
+    // file. A new game truncates the log so the previous game's turns go away
+    if (writingLog.empty() && writingLogFirst != 0) {
+        startSessionWrite();
+        return;
+    }
+    SDL_AsyncIO* file = SDL_AsyncIOFromFile(logPath.c_str(), writingLogFirst == 0 ? "w" : "r+");
+    if (!file) {
+        SDL_Log("Couldn't open %s: %s", logPath.c_str(), SDL_GetError());
+        logTurns = 0;  // write the whole log with the next save
+        return;
+    }
+    // Write, then close with flush; the close completes after the write
+    if (!writingLog.empty() &&
+        !SDL_WriteAsyncIO(file, writingLog.data(), writingLogFirst * 4, writingLog.size(), queue, NULL)) {
+        writeFailed = true;
+    }
+    if (!SDL_CloseAsyncIO(file, true, queue, NULL)) {
+        SDL_Log("Couldn't close %s: %s", logPath.c_str(), SDL_GetError());
+        logTurns = 0;
+        return;
+    }
+    busy = true;
+}
+
+void SessionSaver::startSessionWrite() {
+    writingSession = true;
+    busy = false;
+
+    SDL_AsyncIO* file = SDL_AsyncIOFromFile(tempPath.c_str(), "w");
+    if (!file) {
+        SDL_Log("Couldn't open %s: %s", tempPath.c_str(), SDL_GetError());
+        return;
+    }
+    if (!SDL_WriteAsyncIO(file, writing.data(), 0, writing.size(), queue, NULL)) {
+        writeFailed = true;
+    }
+    if (!SDL_CloseAsyncIO(file, true, queue, NULL)) {
+        SDL_Log("Couldn't close %s: %s", tempPath.c_str(), SDL_GetError());
+        return;
+    }
+    busy = true;
+}
+
+void SessionSaver::handleOutcome(const SDL_AsyncIOOutcome& outcome) {
+    if (outcome.result != SDL_ASYNCIO_COMPLETE) {
+        writeFailed = true;
+    }
+    if (outcome.type != SDL_ASYNCIO_TASK_CLOSE) {
+        return;
+    }
+
+    if (!writingSession) {
+        // The new turns are flushed: now the session file may count them
+        if (!writeFailed) {
+            startSessionWrite();
+            if (busy) {
+                return;
+            }
+        } else {
+            // Leave the old session file alone; the next save rewrites the log
+            // from the start (a waiting save may only have the newest turns)
+            SDL_Log("Couldn't write %s", logPath.c_str());
+            busy = false;
+            logTurns = 0;
+            hasPending = false;
+            return;
+        }
+    } else {
+        // The temporary file is complete and flushed: move it over the session file
+        busy = false;
+        if (writeFailed) {
+            SDL_Log("Couldn't write %s", tempPath.c_str());
+        } else if (!SDL_RenamePath(tempPath.c_str(), path.c_str())) {
+            SDL_Log("Couldn't replace %s: %s", path.c_str(), SDL_GetError());
+        }
+    }
+    if (hasPending) {
+        startWrite();
+    }
+}
+
+void SessionSaver::poll() {
+    if (!queue) {
+        return;
+    }
+    SDL_AsyncIOOutcome outcome;
+    while (SDL_GetAsyncIOResult(queue, &outcome)) {
+        handleOutcome(outcome);
+    }
+}
+
+void SessionSaver::shutdown() {
+    if (!queue) {
+        return;
+    }
+    // handleOutcome starts the pending write, so keep waiting until idle
+    SDL_AsyncIOOutcome outcome;
+    while (busy && SDL_WaitAsyncIOResult(queue, &outcome, -1)) {
+        handleOutcome(outcome);
+    }
+    SDL_DestroyAsyncIOQueue(queue);
+    queue = nullptr;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "game.h"
+#include <SDL3/SDL_asyncio.h>
+#include <string>
+#include <vector>
+
+// A session is two files, so saving after a move never rewrites the whole game:
+//
+// Session file (all integers little-endian), rewritten on every save:
+//   "2048SAV2"  magic
+//   u32 high score, u32 score
+//   u64 seed, u64 rng state
+//   u16 rows, u16 cols, rows * cols x u32 tile value
+//   u32 turn count
+//
+// Turn log, only the turns played since the last save are written:
+//   turn count x { u8 direction, u8 spawn exponent, u16 spawn cell }
+//   (the file can be longer after an undo; records past the turn count are ignored)
+std::vector<Uint8> SerializeSession(const GameContext& ctx);
+// Returns false (leaving ctx alone) if the data is not a valid session: bad
+// header, a tile that is not 0 or a power of two, or a turn log that does not
+// replay from the seed into exactly the saved board, score and RNG state
+bool DeserializeSession(const Uint8* data, size_t size,
+                        const Uint8* log, size_t logSize, GameContext& ctx);
+
+// Turn records [first, ctx.turns.size()) as they are stored in the turn log
+std::vector<Uint8> SerializeTurns(const GameContext& ctx, size_t first);
+
+class SessionSaver {
+public:
+    // Pick the save location (SDL_GetPrefPath) and create the I/O queue
+    bool init(const char* org, const char* app);
+
+    // Restore the previous session into ctx. Returns false if there is none
+    bool load(GameContext& ctx);
+
+    // Queue the current session for writing. Never blocks
+    void save(const GameContext& ctx);
+
+    // Handle finished writes; call once per frame
+    void poll();
+
+    // True while a write is in flight or waiting, i.e. poll() still has work to do
+    bool isBusy() const { return busy || hasPending; }
+
+    // Finish all outstanding writes (blocks) and release the queue
+    void shutdown();
+
+private:
+    void startWrite();
+    void startSessionWrite();
+    void handleOutcome(const SDL_AsyncIOOutcome& outcome);
+
+    SDL_AsyncIOQueue* queue = nullptr;
+    std::string path;
+    std::string tempPath;
+    std::string logPath;
+    // Data of the write in flight (must live until it completes)
+    std::vector<Uint8> writing;
+    std::vector<Uint8> writingLog;
+    size_t writingLogFirst = 0;   // index of the first turn in writingLog
+    // Newest session waiting for the current write to finish, and the turns
+    // [pendingLogFirst, turn count) the log doesn't have yet
+    std::vector<Uint8> pending;
+    std::vector<Uint8> pendingLog;
+    size_t pendingLogFirst = 0;
+    size_t logTurns = 0;          // turns in the log once the queued writes finish
+    bool writingSession = false;  // false: the log part of the write is in flight
+    bool busy = false;
+    bool hasPending = false;
+    bool writeFailed = false;
+};
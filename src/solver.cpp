@@ -0,0 +1,265 @@
+#include "solver.h"
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+// Spawns less likely than this are not searched further, just evaluated
+static const float PROBABILITY_THRESHOLD = 0.0001f;
+
+// Nodes a thread searches between checks of the time and node limits
+static const Uint64 LIMIT_CHECK_INTERVAL = 1024;
+
+static Uint64 NowNs() {
+    return (Uint64)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Per-task search statistics
+struct Solver::Worker {
+    Uint64 nodes = 0;
+    Uint64 flushed = 0;   // part of nodes already added to sharedNodes
+    Uint64 probes = 0;
+    Uint64 hits = 0;
+};
+
+Solver::Solver(int threads, int hashMegabytes) : pool(threads) {
+    setHashSize(hashMegabytes);
+}
+
+void Solver::setHashSize(int megabytes) {
+    size_t entries = 1;
+    while (entries * 2 * sizeof(TTEntry) <= (size_t)std::max(megabytes, 1) * 1024 * 1024) {
+        entries *= 2;
+    }
+    table.reset(new TTEntry[entries]);
+    tableMask = entries - 1;
+    clearHash();
+}
+
+void Solver::clearHash() {
+    for (size_t i = 0; i <= tableMask; i++) {
+        table[i].check.store(0, std::memory_order_relaxed);
+        table[i].data.store(0, std::memory_order_relaxed);
+    }
+}
+
+static size_t HashBoard(Board board) {
+    board ^= board >> 29;
+    board *= 0xBF58476D1CE4E5B9ull;
+    board ^= board >> 32;
+    return (size_t)board;
+}
+
+bool Solver::probe(Board board, int depth, float& value, Worker& worker) {
+    worker.probes++;
+    TTEntry& entry = table[HashBoard(board) & tableMask];
+    Uint64 data = entry.data.load(std::memory_order_relaxed);
+    Uint64 check = entry.check.load(std::memory_order_relaxed);
+    if ((check ^ data) != board || (int)(data & 0xFF) < depth) {
+        return false;
+    }
+    Uint32 bits = (Uint32)(data >> 8);
+    memcpy(&value, &bits, sizeof(value));
+    worker.hits++;
+    return true;
+}
+
+void Solver::store(Board board, int depth, float value) {
+    Uint32 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    Uint64 data = ((Uint64)bits << 8) | (Uint64)depth;
+    TTEntry& entry = table[HashBoard(board) & tableMask];
+    entry.data.store(data, std::memory_order_relaxed);
+    entry.check.store(board ^ data, std::memory_order_relaxed);
+}
+
+float Solver::evaluate(Board board) const {
+    const BoardTables& tables = GetBoardTables();
+    Board transposed = BoardTranspose(board);
+    float score = 0.0f;
+    for (int row = 0; row < BOARD_SIZE; row++) {
+        score += tables.heuristic[(board >> (16 * row)) & 0xFFFF];
+        score += tables.heuristic[(transposed >> (16 * row)) & 0xFFFF];
+    }
+    return score;
+}
+
+// Player to move: take the best move (0 if there is none - game over)
+float Solver::maxNode(Board board, int depth, float probability, Worker& worker) {
+    worker.nodes++;
+    float best = 0.0f;
+    for (int dir = 0; dir < 4; dir++) {
+        Board moved = BoardMove(board, (Grid::Direction)dir);
+        if (moved != board) {
+            best = std::max(best, chanceNode(moved, depth - 1, probability, worker));
+        }
+    }
+    return best;
+}
+
+// A tile is about to spawn: average over every cell and value
+float Solver::chanceNode(Board board, int depth, float probability, Worker& worker) {
+    worker.nodes++;
+    if (depth <= 0 || probability < PROBABILITY_THRESHOLD) {
+        return evaluate(board);
+    }
+
+    // Check the limits now and then
+    if (limitsActive && worker.nodes - worker.flushed >= LIMIT_CHECK_INTERVAL) {
+        Uint64 total = sharedNodes.fetch_add(worker.nodes - worker.flushed) + (worker.nodes - worker.flushed);
+        worker.flushed = worker.nodes;
+        if ((nodeLimit && total >= nodeLimit) || (deadlineNs && NowNs() >= deadlineNs)) {
+            stopRequested = true;
+        }
+    }
+    if (stopRequested.load(std::memory_order_relaxed)) {
+        return 0.0f;
+    }
+
+    float value;
+    if (probe(board, depth, value, worker)) {
+        return value;
+    }
+
+    int empty = BoardCountEmpty(board);
+    probability /= (float)empty;
+    float sum = 0.0f;
+    for (int i = 0; i < BOARD_CELLS; i++) {
+        if (BoardGetExponent(board, i) != 0) {
+            continue;
+        }
+        sum += 0.9f * maxNode(BoardSetExponent(board, i, 1), depth, probability * 0.9f, worker);
+        sum += 0.1f * maxNode(BoardSetExponent(board, i, 2), depth, probability * 0.1f, worker);
+    }
+    value = sum / (float)empty;
+
+    // An interrupted search gives wrong values; don't keep them
+    if (!stopRequested.load(std::memory_order_relaxed)) {
+        store(board, depth, value);
+    }
+    return value;
+}
+
+SearchResult Solver::search(Board board, const SearchLimits& limits,
+                            const std::function<void(const SearchResult&)>& onIteration) {
+    TRACE_SCOPE("Solver::search");
+    Uint64 start = NowNs();
+    stopRequested = false;
+    sharedNodes = 0;
+    nodeLimit = limits.nodes;
+    deadlineNs = limits.movetimeMs ? start + limits.movetimeMs * 1000000ull : 0;
+
+    int maxDepth = DEFAULT_DEPTH;
+    if (limits.depth > 0) {
+        maxDepth = std::min(limits.depth, MAX_DEPTH);
+    } else if (limits.movetimeMs || limits.nodes) {
+        maxDepth = MAX_DEPTH;
+    }
+
+    // Legal moves at the root
+    std::vector<MoveScore> moves;
+    std::vector<Board> movedBoards;
+    for (int dir = 0; dir < 4; dir++) {
+        Board moved = BoardMove(board, (Grid::Direction)dir);
+        if (moved != board) {
+            moves.push_back({ (Grid::Direction)dir, 0.0 });
+            movedBoards.push_back(moved);
+        }
+    }
+
+    SearchResult result;
+    Uint64 totalNodes = 0;
+    Uint64 totalProbes = 0;
+    Uint64 totalHits = 0;
+    if (moves.empty()) {
+        result.seconds = (NowNs() - start) / 1e9;
+        return result;
+    }
+
+    for (int depth = 1; depth <= maxDepth; depth++) {
+        TRACE_SCOPE("Solver::iteration");
+        // The first iteration always completes, so there is always a move
+        limitsActive = depth > 1;
+
+        // One task per (move, empty cell, spawned value) below the root
+        struct Task {
+            size_t move;
+            Board board;
+            float weight;   // spawn probability / empty cells
+            float value;
+            Worker worker;
+        };
+        std::vector<Task> tasks;
+        for (size_t m = 0; m < moves.size(); m++) {
+            if (depth == 1) {
+                tasks.push_back({ m, movedBoards[m], 1.0f, 0.0f, {} });
+                continue;
+            }
+            int empty = BoardCountEmpty(movedBoards[m]);
+            for (int i = 0; i < BOARD_CELLS; i++) {
+                if (BoardGetExponent(movedBoards[m], i) == 0) {
+                    tasks.push_back({ m, BoardSetExponent(movedBoards[m], i, 1), 0.9f / empty, 0.0f, {} });
+                    tasks.push_back({ m, BoardSetExponent(movedBoards[m], i, 2), 0.1f / empty, 0.0f, {} });
+                }
+            }
+        }
+
+        std::vector<std::function<void()>> batch;
+        batch.reserve(tasks.size());
+        for (Task& task : tasks) {
+            batch.push_back([this, &task, depth]() {
+                TRACE_SCOPE("Solver::task");
+                if (depth == 1) {
+                    task.worker.nodes++;
+                    task.value = evaluate(task.board);
+                } else {
+                    task.value = maxNode(task.board, depth - 1, task.weight, task.worker);
+                }
+            });
+        }
+        {
+            TRACE_SCOPE("Solver::runTasks");
+            pool.run(batch);
+        }
+
+        for (const Task& task : tasks) {
+            totalNodes += task.worker.nodes;
+            totalProbes += task.worker.probes;
+            totalHits += task.worker.hits;
+        }
+        if (stopRequested) {
+            break;  // Incomplete iteration: keep the previous one
+        }
+
+        for (MoveScore& move : moves) {
+            move.value = 0.0;
+        }
+        for (const Task& task : tasks) {
+            moves[task.move].value += (depth == 1) ? task.value : task.weight * task.value;
+        }
+        result.moves = moves;
+        std::stable_sort(result.moves.begin(), result.moves.end(),
+            [](const MoveScore& a, const MoveScore& b) { return a.value > b.value; });
+        result.depth = depth;
+        result.nodes = totalNodes;
+        result.ttProbes = totalProbes;
+        result.ttHits = totalHits;
+        result.seconds = (NowNs() - start) / 1e9;
+        if (onIteration) {
+            onIteration(result);
+        }
+        if (deadlineNs && NowNs() >= deadlineNs) {
+            break;
+        }
+        if (nodeLimit && totalNodes >= nodeLimit) {
+            break;
+        }
+    }
+
+    result.nodes = totalNodes;
+    result.ttProbes = totalProbes;
+    result.ttHits = totalHits;
+    result.seconds = (NowNs() - start) / 1e9;
+    return result;
+}
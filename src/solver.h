@@ -0,0 +1,81 @@
+#pragma once
+
+#include "bitboard.h"
+#include "thread_pool.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// SearchLimits - how long the solver may think. 0 means "no limit" for each
+// field; with no limits at all the solver searches to DEFAULT_DEPTH
+struct SearchLimits {
+    int depth = 0;              // maximum depth in moves
+    Uint64 movetimeMs = 0;      // wall clock budget
+    Uint64 nodes = 0;           // node budget
+};
+
+// Expected value of one legal move
+struct MoveScore {
+    Grid::Direction dir;
+    double value;
+};
+
+// SearchResult - the last fully completed iteration of a search
+struct SearchResult {
+    std::vector<MoveScore> moves;   // legal moves, best first (empty = game over)
+    int depth = 0;                  // depth of the completed iteration
+    Uint64 nodes = 0;               // nodes searched in total
+    double seconds = 0.0;
+    Uint64 ttProbes = 0;
+    Uint64 ttHits = 0;
+
+    double nodesPerSecond() const { return seconds > 0.0 ? nodes / seconds : 0.0; }
+};
+
+// Solver - expectimax search over Board positions
+// Iterative deepening until the limits are reached. The work below the root
+// (every move x spawn) is spread over a ThreadPool, and all threads share one
+// lock-free transposition table. Pool and table are kept between searches,
+// so repeated searches on related positions start warm.
+class Solver {
+public:
+    static constexpr int DEFAULT_DEPTH = 3;
+    static constexpr int MAX_DEPTH = 20;
+
+    explicit Solver(int threads = 0, int hashMegabytes = 64);
+
+    void setThreads(int threads) { pool.resize(threads); }
+    int getThreads() const { return pool.size(); }
+    void setHashSize(int megabytes);
+    void clearHash();
+
+    // Search a position. onIteration (if given) is called after each completed depth
+    SearchResult search(Board board, const SearchLimits& limits,
+                        const std::function<void(const SearchResult&)>& onIteration = {});
+
+    // Ask a running search to stop (from another thread)
+    void stop() { stopRequested = true; }
+
+private:
+    struct TTEntry {
+        std::atomic<Uint64> check;  // key ^ data, so torn writes are detected
+        std::atomic<Uint64> data;   // value (float bits) << 8 | depth
+    };
+    struct Worker;
+
+    bool probe(Board board, int depth, float& value, Worker& worker);
+    void store(Board board, int depth, float value);
+    float evaluate(Board board) const;
+    float maxNode(Board board, int depth, float probability, Worker& worker);
+    float chanceNode(Board board, int depth, float probability, Worker& worker);
+
+    ThreadPool pool;
+    std::unique_ptr<TTEntry[]> table;
+    size_t tableMask = 0;
+    std::atomic<bool> stopRequested{false};
+    std::atomic<Uint64> sharedNodes{0};
+    Uint64 nodeLimit = 0;
+    Uint64 deadlineNs = 0;
+    bool limitsActive = false;
+};
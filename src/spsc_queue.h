@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// SpscQueue - fixed-size lock-free queue for one producer and one consumer thread
+// push() is only called from the producer, pop() only from the consumer.
+// Neither blocks nor allocates; push() fails when the queue is full.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    bool push(const T& item) {
+        size_t tail = writePos.load(std::memory_order_relaxed);
+        if (tail - readPos.load(std::memory_order_acquire) == Capacity) {
+            return false;  // full
+        }
+        items[tail & (Capacity - 1)] = item;
+        writePos.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& item) {
+        size_t head = readPos.load(std::memory_order_relaxed);
+        if (head == writePos.load(std::memory_order_acquire)) {
+            return false;  // empty
+        }
+        item = items[head & (Capacity - 1)];
+        readPos.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return readPos.load(std::memory_order_acquire) == writePos.load(std::memory_order_acquire);
+    }
+
+private:
+    T items[Capacity] = {};
+    // On separate cache lines so the two threads don't slow each other down
+    alignas(64) std::atomic<size_t> writePos{0};
+    alignas(64) std::atomic<size_t> readPos{0};
+};
@@ -0,0 +1,69 @@
+#include "text.h"
+#include <cstdio>     // for snprintf
+#include <cstring>    // for strlen
+
+// Calculate the width of text when rendered with scaling
+// This helps position text dynamically to prevent overlap
+float GetScaledTextWidth(const char* text, float scale) {
+    // SDL_DEBUG_TEXT_FONT_CHARACTER_SIZE is 8 pixels per character
+    // With scaling, each character is 8 * scale pixels wide
+    return (float)(strlen(text) * 8 * scale);
+}
+
+// Calculate the height of text when rendered with scaling
+float GetScaledTextHeight(float scale) {
+    // SDL_DEBUG_TEXT_FONT_CHARACTER_SIZE is 8 pixels tall
+    return 8.0f * scale;
+}
+
+// Helper function to render scaled text
+// This temporarily scales the renderer, draws text, then restores the scale
+// The text scale goes on top of the current one (e.g. a high-DPI layer or atlas)
+void RenderScaledText(SDL_Renderer* renderer, float x, float y, const char* text, float scale) {
+    // Save current render scale
+    float oldScaleX, oldScaleY;
+    SDL_GetRenderScale(renderer, &oldScaleX, &oldScaleY);
+    
+    // Set render scale to make text larger
+    SDL_SetRenderScale(renderer, oldScaleX * scale, oldScaleY * scale);
+    
+    // Adjust coordinates for scaled rendering (divide by scale)
+    float scaledX = x / scale;
+    float scaledY = y / scale;
+    
+    // Draw the text
+    SDL_RenderDebugText(renderer, scaledX, scaledY, text);
+    
+    // Restore original render scale
+    SDL_SetRenderScale(renderer, oldScaleX, oldScaleY);
+}
+
+// Draw a tile's number text centered on the tile (scaled up)
+void DrawTileText(SDL_Renderer* renderer, const Tile& tile, float tileWidth, float tileHeight) {
+    if (tile.isEmpty()) {
+        return;  // Don't draw text for empty tiles
+    }
+    
+    // Convert number to string
+    char text[32];
+    snprintf(text, sizeof(text), "%d", tile.value);
+    
+    // Calculate text position (centered on tile)
+    SDL_FRect tileRect = tile.getRect(tileWidth, tileHeight);
+    
+    // Calculate text dimensions using helper function
+    float textWidth = GetScaledTextWidth(text);
+    float textHeight = GetScaledTextHeight();
+    
+    // Center the text
+    float textX = tileRect.x + (tileRect.w - textWidth) / 2.0f;
+    float textY = tileRect.y + (tileRect.h - textHeight) / 2.0f;
+    
+    // Set text color - dark for light tiles, light for dark tiles
+    Uint8 r, g, b;
+    tile.getTextColor(r, g, b);
+    SDL_SetRenderDrawColor(renderer, r, g, b, 255);
+    
+    // Draw the text using scaled rendering
+    RenderScaledText(renderer, textX, textY, text);
+}
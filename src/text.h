@@ -0,0 +1,22 @@
+#pragma once
+
+#include <SDL3/SDL_render.h>
+#include "game.h"
+
+// Text scaling factor - makes text 2.5x larger (8px * 2.5 = 20px)
+// Reduced from 3.0 to prevent overlap
+const float TEXT_SCALE = 2.5f;
+
+// Calculate the width of text when rendered with scaling
+// This helps position text dynamically to prevent overlap
+float GetScaledTextWidth(const char* text, float scale = TEXT_SCALE);
+
+// Calculate the height of text when rendered with scaling
+float GetScaledTextHeight(float scale = TEXT_SCALE);
+
+// Helper function to render scaled text with SDL_RenderDebugText
+// This temporarily scales the renderer, draws text, then restores the scale
+void RenderScaledText(SDL_Renderer* renderer, float x, float y, const char* text, float scale = TEXT_SCALE);
+
+// Draw a tile's number text centered on the tile (scaled up)
+void DrawTileText(SDL_Renderer* renderer, const Tile& tile, float tileWidth, float tileHeight);
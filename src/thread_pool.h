@@ -0,0 +1,108 @@
+#pragma once
+
+#include "trace.h"
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ThreadPool - a fixed set of worker threads that stay alive between jobs
+// run() hands out a batch of tasks and blocks until all of them are done.
+// With one thread (or zero workers) the tasks simply run on the caller.
+class ThreadPool {
+public:
+    explicit ThreadPool(int threadCount = 0) { resize(threadCount); }
+    ~ThreadPool() { resize(0); }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Number of threads working on a batch, including the caller
+    int size() const { return (int)workers.size() + 1; }
+
+    // Change the number of threads (0 = one per core). Must not be called during run()
+    void resize(int threadCount) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        workers.clear();
+        quit = false;
+
+        if (threadCount <= 0) {
+            threadCount = (int)std::thread::hardware_concurrency();
+        }
+        for (int i = 1; i < threadCount; i++) {
+            workers.emplace_back([this]() { workerLoop(); });
+        }
+    }
+
+    // Run every task once, spread over the pool and the calling thread
+    void run(const std::vector<std::function<void()>>& batch) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks = &batch;
+            nextTask = 0;
+            unfinished = batch.size();
+            generation++;
+        }
+        wake.notify_all();
+        work(generation);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this]() { return unfinished == 0; });
+        tasks = nullptr;
+    }
+
+private:
+    // Take tasks of the current batch until none are left
+    void work(unsigned long long batchGeneration) {
+        for (;;) {
+            size_t index;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!tasks || generation != batchGeneration || nextTask >= tasks->size()) {
+                    return;
+                }
+                index = nextTask++;
+            }
+            (*tasks)[index]();
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--unfinished == 0) {
+                done.notify_all();
+            }
+        }
+    }
+
+    void workerLoop() {
+        TRACE_THREAD_NAME("pool worker");
+        unsigned long long seen = 0;
+        for (;;) {
+            unsigned long long current;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&]() { return quit || (tasks && generation != seen); });
+                if (quit) {
+                    return;
+                }
+                current = seen = generation;
+            }
+            work(current);
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::vector<std::function<void()>>* tasks = nullptr;
+    size_t nextTask = 0;
+    size_t unfinished = 0;
+    unsigned long long generation = 0;
+    bool quit = false;
+};
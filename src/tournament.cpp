@@ -0,0 +1,104 @@
+#include "tournament.h"
+#include "solver.h"
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+
+// Put a new tile (2 with 90%, 4 with 10%) on a random empty cell, like PlayTurn
+static Board SpawnTile(Board board, Rng& rng) {
+    int empty = BoardCountEmpty(board);
+    if (empty == 0) {
+        return board;
+    }
+    int exponent = (rng.below(10) == 0) ? 2 : 1;
+    int target = rng.below(empty);
+    for (int i = 0; i < BOARD_CELLS; i++) {
+        if (BoardGetExponent(board, i) == 0 && target-- == 0) {
+            return BoardSetExponent(board, i, exponent);
+        }
+    }
+    return board;
+}
+
+static int MaxExponent(Board board) {
+    int best = 0;
+    for (int i = 0; i < BOARD_CELLS; i++) {
+        best = std::max(best, BoardGetExponent(board, i));
+    }
+    return best;
+}
+
+void Tournament::start(int count, int threads, Uint64 seed) {
+    stop();
+    gameCount = std::clamp(count, 1, MAX_GAMES);
+    games = std::make_unique<Game[]>(gameCount);
+    nextSeed = seed;
+    movesPlayed = 0;
+    nodesSearched = 0;
+    gamesFinished = 0;
+    bestExponent = 0;
+    for (int i = 0; i < gameCount; i++) {
+        newGame(games[i], nextSeed++);
+    }
+
+    if (threads <= 0) {
+        threads = (int)std::thread::hardware_concurrency();
+    }
+    threads = std::clamp(threads, 1, gameCount);
+    quit = false;
+    for (int i = 0; i < threads; i++) {
+        workers.emplace_back([this, i, threads]() { workerLoop(i, threads); });
+    }
+}
+
+void Tournament::stop() {
+    quit = true;
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+}
+
+void Tournament::newGame(Game& game, Uint64 seed) {
+    game.rng = Rng(seed);
+    Board board = SpawnTile(SpawnTile(0, game.rng), game.rng);
+    game.board.store(board, std::memory_order_relaxed);
+}
+
+void Tournament::workerLoop(int first, int step) {
+    TRACE_THREAD_NAME("tournament");
+    // A small table is plenty for shallow searches
+    Solver solver(1, 1);
+    SearchLimits limits;
+    limits.depth = SEARCH_DEPTH;
+
+    while (!quit.load(std::memory_order_relaxed)) {
+        // One pass moves each of this worker's games once; at a limited
+        // speed each pass takes (at least) 1 / speed seconds
+        auto passStart = std::chrono::steady_clock::now();
+        for (int i = first; i < gameCount && !quit.load(std::memory_order_relaxed); i += step) {
+            Game& game = games[i];
+            Board board = game.board.load(std::memory_order_relaxed);
+            SearchResult result = solver.search(board, limits);
+            nodesSearched.fetch_add(result.nodes, std::memory_order_relaxed);
+
+            if (result.moves.empty()) {
+                // Game over: remember the best tile and start again
+                int exponent = MaxExponent(board);
+                int best = bestExponent.load(std::memory_order_relaxed);
+                while (exponent > best && !bestExponent.compare_exchange_weak(best, exponent)) {
+                }
+                gamesFinished.fetch_add(1, std::memory_order_relaxed);
+                newGame(game, nextSeed.fetch_add(1, std::memory_order_relaxed));
+                continue;
+            }
+            board = SpawnTile(BoardMove(board, result.moves[0].dir), game.rng);
+            game.board.store(board, std::memory_order_relaxed);
+            movesPlayed.fetch_add(1, std::memory_order_relaxed);
+        }
+        int movesPerSecond = speed.load(std::memory_order_relaxed);
+        if (movesPerSecond > 0) {
+            std::this_thread::sleep_until(passStart + std::chrono::nanoseconds(1000000000 / movesPerSecond));
+        }
+    }
+}
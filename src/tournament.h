@@ -0,0 +1,63 @@
+#pragma once
+
+#include "bitboard.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Tournament - many AI games playing at once, for the spectator view
+// Worker threads each own a slice of the games and a small single-threaded
+// Solver, and play their games round-robin, at most getSpeed() moves per
+// second per game (0 = as fast as they can). Every game's
+// board is one atomic 64-bit Board, so the renderer can read the newest
+// state of any game at any time without locks. Finished games are counted
+// and restarted from a new seed.
+class Tournament {
+public:
+    static const int MAX_GAMES = 1024;
+    static const int SEARCH_DEPTH = 1;
+    static const int DEFAULT_SPEED = 20;  // moves per second per game
+
+    ~Tournament() { stop(); }
+
+    // Start `games` games on `threads` worker threads (0 = one per core)
+    void start(int games, int threads = 0, Uint64 seed = 1);
+    void stop();
+
+    int getGameCount() const { return gameCount; }
+
+    // Moves per second per game, 0 = unlimited (any thread)
+    void setSpeed(int movesPerSecond) { speed.store(std::max(movesPerSecond, 0), std::memory_order_relaxed); }
+    int getSpeed() const { return speed.load(std::memory_order_relaxed); }
+
+    // Newest board of a game (any thread)
+    Board getBoard(int game) const { return games[game].board.load(std::memory_order_relaxed); }
+
+    // Totals since start (any thread)
+    Uint64 getMovesPlayed() const { return movesPlayed.load(std::memory_order_relaxed); }
+    Uint64 getNodesSearched() const { return nodesSearched.load(std::memory_order_relaxed); }
+    int getGamesFinished() const { return gamesFinished.load(std::memory_order_relaxed); }
+    int getBestExponent() const { return bestExponent.load(std::memory_order_relaxed); }
+
+private:
+    struct Game {
+        std::atomic<Board> board{0};
+        Rng rng{0};  // spawns; only used by the game's worker
+    };
+
+    void workerLoop(int first, int step);
+    void newGame(Game& game, Uint64 seed);
+
+    std::unique_ptr<Game[]> games;
+    int gameCount = 0;
+    std::vector<std::thread> workers;
+    std::atomic<bool> quit{false};
+    std::atomic<int> speed{DEFAULT_SPEED};
+    std::atomic<Uint64> movesPlayed{0};
+    std::atomic<Uint64> nodesSearched{0};
+    std::atomic<int> gamesFinished{0};
+    std::atomic<int> bestExponent{0};
+    std::atomic<Uint64> nextSeed{0};
+};
@@ -0,0 +1,105 @@
+#include "trace.h"
+#include "error.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <vector>
+
+// TraceEvent - one finished scope
+struct TraceEvent {
+    const char* name;
+    Uint64 startNs;
+    Uint64 endNs;
+};
+
+// TraceRing - the events of one thread
+// Only the owning thread writes; `written` counts every event ever recorded,
+// so the newest is at (written - 1) & mask and the oldest still kept at
+// written - TRACE_RING_EVENTS
+struct TraceRing {
+    TraceEvent events[TRACE_RING_EVENTS];
+    std::atomic<Uint64> written{0};
+    std::atomic<const char*> threadName{nullptr};
+    int threadId = 0;
+    TraceRing* next = nullptr;
+};
+
+// All rings, newest first. Rings are never freed: a thread may finish before
+// the trace is written, and its events should still be in it
+static std::atomic<TraceRing*> rings{nullptr};
+static std::atomic<int> ringCount{0};
+static thread_local TraceRing* threadRing = nullptr;
+
+static TraceRing* GetThreadRing() {
+    if (!threadRing) {
+        TraceRing* ring = new TraceRing();
+        ring->threadId = ringCount.fetch_add(1) + 1;
+        ring->next = rings.load(std::memory_order_relaxed);
+        while (!rings.compare_exchange_weak(ring->next, ring, std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+        }
+        threadRing = ring;
+    }
+    return threadRing;
+}
+
+void TraceRecord(const char* name, Uint64 startNs, Uint64 endNs) {
+    TraceRing* ring = GetThreadRing();
+    Uint64 n = ring->written.load(std::memory_order_relaxed);
+    ring->events[n & (TRACE_RING_EVENTS - 1)] = { name, startNs, endNs };
+    ring->written.store(n + 1, std::memory_order_release);
+}
+
+void TraceSetThreadName(const char* name) {
+    GetThreadRing()->threadName.store(name, std::memory_order_relaxed);
+}
+
+bool TraceWrite(const char* path, std::string* error) {
+    // Copy the events first: timestamps are written relative to the oldest one
+    struct ThreadEvents {
+        const TraceRing* ring;
+        std::vector<TraceEvent> events;
+    };
+    std::vector<ThreadEvents> threads;
+    Uint64 epochNs = UINT64_MAX;
+    for (TraceRing* ring = rings.load(std::memory_order_acquire); ring; ring = ring->next) {
+        Uint64 end = ring->written.load(std::memory_order_acquire);
+        Uint64 begin = end > TRACE_RING_EVENTS ? end - TRACE_RING_EVENTS : 0;
+        ThreadEvents thread{ ring, {} };
+        for (Uint64 i = begin; i < end; i++) {
+            thread.events.push_back(ring->events[i & (TRACE_RING_EVENTS - 1)]);
+        }
+        // Drop the events the thread overwrote while we were copying
+        Uint64 after = ring->written.load(std::memory_order_acquire);
+        Uint64 overwritten = std::min<Uint64>(after - end, thread.events.size());
+        thread.events.erase(thread.events.begin(), thread.events.begin() + overwritten);
+        for (const TraceEvent& event : thread.events) {
+            epochNs = std::min(epochNs, event.startNs);
+        }
+        threads.push_back(std::move(thread));
+    }
+
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        return Fail(error, std::string("can't create ") + path);
+    }
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"game2048\"}}");
+    for (const ThreadEvents& thread : threads) {
+        int tid = thread.ring->threadId;
+        const char* threadName = thread.ring->threadName.load(std::memory_order_relaxed);
+        if (threadName) {
+            fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                    tid, threadName);
+        }
+        // Complete ("X") events in microseconds; the viewer nests them by time
+        for (const TraceEvent& event : thread.events) {
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    event.name, tid, (event.startNs - epochNs) / 1e3, (event.endNs - event.startNs) / 1e3);
+        }
+    }
+    fprintf(file, "\n]}\n");
+    bool ok = !ferror(file);
+    ok = fclose(file) == 0 && ok;
+    return ok ? true : Fail(error, std::string("can't write ") + path);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+// Chrome trace instrumentation: timelines for chrome://tracing or ui.perfetto.dev
+//
+//   TRACE_SCOPE("DrawGame");     time from here to the end of the enclosing block
+//   TRACE_THREAD_NAME("game");   label the calling thread in the timeline
+//
+// The macros only do something when the build defines GAME2048_TRACE
+// (cmake -DGAME2048_TRACE=ON); otherwise they expand to nothing and none of
+// this header's code is compiled in, so shipping builds pay nothing.
+//
+// Every thread records into its own ring buffer without locks, keeping its
+// newest TRACE_RING_EVENTS events. TraceWrite() saves all threads' events as
+// Chrome trace JSON. Names must be string literals (only the pointer is kept).
+
+#ifdef GAME2048_TRACE
+
+#include <SDL3/SDL_stdinc.h>
+#include <chrono>
+#include <string>
+
+const size_t TRACE_RING_EVENTS = 1 << 16;  // per thread, a power of two
+
+// The clock events are recorded with, in nanoseconds
+inline Uint64 TraceNowNs() {
+    return (Uint64)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Add a finished event to the calling thread's ring
+void TraceRecord(const char* name, Uint64 startNs, Uint64 endNs);
+
+// Name the calling thread in the trace
+void TraceSetThreadName(const char* name);
+
+// Write every thread's events to a JSON file. Threads should be idle (or
+// stopped) by now; events a busy thread overwrites while they are copied are
+// left out. On failure return false and describe the problem in error (if given)
+bool TraceWrite(const char* path, std::string* error = nullptr);
+
+// TraceScope - records one event from construction to destruction
+class TraceScope {
+public:
+    explicit TraceScope(const char* scopeName) : name(scopeName), startNs(TraceNowNs()) {}
+    ~TraceScope() { TraceRecord(name, startNs, TraceNowNs()); }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name;
+    Uint64 startNs;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+#define TRACE_THREAD_NAME(name) TraceSetThreadName(name)
+
+#else
+
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_THREAD_NAME(name) ((void)0)
+
+#endif
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+
+// TripleBuffer - hands the newest value from one writer thread to one reader thread
+// The writer fills writeBuffer() and publish()es it; the reader calls update()
+// and then uses readBuffer(). With three buffers neither side ever waits for
+// the other or sees a half-written value. Values published between two
+// update() calls are skipped; the reader always gets the newest one.
+template <typename T>
+class TripleBuffer {
+public:
+    // Writer: the buffer to fill next
+    T& writeBuffer() { return buffers[writeIndex]; }
+
+    // Writer: make writeBuffer() the newest value
+    void publish() {
+        int previous = middle.exchange(writeIndex | FRESH, std::memory_order_acq_rel);
+        writeIndex = previous & INDEX_MASK;
+    }
+
+    // Reader: switch to the newest value. Returns false if nothing new was published
+    bool update() {
+        if ((middle.load(std::memory_order_acquire) & FRESH) == 0) {
+            return false;
+        }
+        readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+
+    // Reader: the value from the last successful update()
+    const T& readBuffer() const { return buffers[readIndex]; }
+
+private:
+    static const int FRESH = 4;       // set while middle holds a value the reader hasn't taken
+    static const int INDEX_MASK = 3;
+
+    T buffers[3] = {};
+    int writeIndex = 0;               // only touched by the writer
+    int readIndex = 1;                // only touched by the reader
+    std::atomic<int> middle{2};       // the buffer passed between them
+};
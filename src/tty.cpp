@@ -0,0 +1,393 @@
+// game2048-tty - play or watch 2048 in a terminal (over SSH, on headless servers)
+//
+// Usage: game2048-tty [--replay file | --ai [depth]] [--speed moves/s] [--seed n]
+//
+//   (no options)     play: arrow keys or WASD to move, r to restart
+//   --replay file    watch a recorded game
+//   --ai [depth]     watch the analysis engine play (default depth 2)
+//   --speed n        moves per second when watching (default 10)
+//
+// Watching: space pauses, + / - change the speed. q quits.
+//
+// The board is drawn with ANSI escape codes (24-bit colors). Only cells whose
+// value changed since the last frame are rewritten, and each frame goes out in
+// a single write(), so a move costs a few hundred bytes instead of a screenful.
+// Needs a POSIX terminal.
+#include "bitboard.h"
+#include "replay.h"
+#include "solver.h"
+#include <algorithm>
+#include <array>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <poll.h>
+#include <string>
+#include <termios.h>
+#include <unistd.h>
+
+// Board layout in character cells
+const int CELL_WIDTH = 7;
+const int CELL_HEIGHT = 3;
+const int BOARD_TOP = 3;    // terminal row of the board's top edge (1-based)
+const int BOARD_LEFT = 2;   // terminal column of the board's left edge
+const int BOARD_COLUMNS = GRID_COLS * (CELL_WIDTH + 1) + 1;
+const int BOARD_LINES = GRID_ROWS * (CELL_HEIGHT + 1) + 1;
+const int STATUS_ROW = BOARD_TOP + BOARD_LINES + 1;
+
+const int DEFAULT_SPEED = 10;
+const int MAX_SPEED = 1000;
+
+// TtyRenderer - draws a GameContext, rewriting only what changed
+class TtyRenderer {
+public:
+    // Draw everything again on the next frame (first frame, terminal resized)
+    void invalidate() { full = true; }
+
+    void draw(const GameContext& ctx, const std::string& status);
+
+    Uint64 getFrames() const { return frames; }
+    Uint64 getBytesWritten() const { return bytesWritten; }
+
+private:
+    void moveTo(int row, int column);
+    void setColors(Uint8 r, Uint8 g, Uint8 b, Uint8 textR, Uint8 textG, Uint8 textB);
+    void drawCell(int index, int value);
+    void flush();
+
+    std::string out;  // escape codes of the frame being built
+    bool full = true;
+    std::array<int, GRID_ROWS * GRID_COLS> shown{};
+    int shownScore = -1;
+    int shownHighScore = -1;
+    std::string shownStatus;
+    Uint64 frames = 0;
+    Uint64 bytesWritten = 0;
+};
+
+void TtyRenderer::moveTo(int row, int column) {
+    char code[24];
+    snprintf(code, sizeof(code), "\x1b[%d;%dH", row, column);
+    out += code;
+}
+
+void TtyRenderer::setColors(Uint8 r, Uint8 g, Uint8 b, Uint8 textR, Uint8 textG, Uint8 textB) {
+    char code[48];
+    snprintf(code, sizeof(code), "\x1b[48;2;%d;%d;%dm\x1b[38;2;%d;%d;%dm", r, g, b, textR, textG, textB);
+    out += code;
+}
+
+// A cell is CELL_HEIGHT lines of CELL_WIDTH colored spaces with the number in the middle
+void TtyRenderer::drawCell(int index, int value) {
+    Tile tile(value);
+    Uint8 r, g, b, textR, textG, textB;
+    tile.getColor(r, g, b);
+    tile.getTextColor(textR, textG, textB);
+    setColors(r, g, b, textR, textG, textB);
+
+    char number[CELL_WIDTH + 1] = "";
+    if (value != 0) {
+        snprintf(number, sizeof(number), "%d", value);
+    }
+    int length = (int)strlen(number);
+    char line[CELL_WIDTH + 1];
+    int row = BOARD_TOP + 1 + (index / GRID_COLS) * (CELL_HEIGHT + 1);
+    int column = BOARD_LEFT + 1 + (index % GRID_COLS) * (CELL_WIDTH + 1);
+    for (int i = 0; i < CELL_HEIGHT; i++) {
+        memset(line, ' ', CELL_WIDTH);
+        line[CELL_WIDTH] = '\0';
+        if (i == CELL_HEIGHT / 2) {
+            memcpy(line + (CELL_WIDTH - length) / 2, number, length);
+        }
+        moveTo(row + i, column);
+        out += line;
+    }
+}
+
+void TtyRenderer::draw(const GameContext& ctx, const std::string& status) {
+    out.clear();
+    if (full) {
+        // Clear the screen and draw the board background once
+        out += "\x1b[0m\x1b[2J";
+        setColors(187, 173, 160, 0, 0, 0);
+        std::string background(BOARD_COLUMNS, ' ');
+        for (int i = 0; i < BOARD_LINES; i++) {
+            moveTo(BOARD_TOP + i, BOARD_LEFT);
+            out += background;
+        }
+    }
+
+    // Cells that changed
+    for (int i = 0; i < (int)shown.size(); i++) {
+        int value = ctx.grid.at(i).value;
+        if (full || value != shown[i]) {
+            drawCell(i, value);
+            shown[i] = value;
+        }
+    }
+
+    // Score line and status line
+    if (full || ctx.score != shownScore || ctx.high_score != shownHighScore) {
+        out += "\x1b[0m";
+        char text[64];
+        snprintf(text, sizeof(text), "2048   Score: %d   Best: %d", ctx.score, ctx.high_score);
+        moveTo(1, BOARD_LEFT);
+        out += text;
+        out += "\x1b[K";  // erase the rest of the line
+        shownScore = ctx.score;
+        shownHighScore = ctx.high_score;
+    }
+    if (full || status != shownStatus) {
+        out += "\x1b[0m";
+        moveTo(STATUS_ROW, BOARD_LEFT);
+        out += status;
+        out += "\x1b[K";
+        shownStatus = status;
+    }
+    full = false;
+    if (!out.empty()) {
+        moveTo(STATUS_ROW + 1, 1);  // park the cursor below the board
+        flush();
+        frames++;
+    }
+}
+
+// Send the whole frame with as few write() calls as the terminal allows (normally one)
+void TtyRenderer::flush() {
+    const char* data = out.data();
+    size_t left = out.size();
+    while (left > 0) {
+        ssize_t written = write(STDOUT_FILENO, data, left);
+        if (written <= 0) {
+            break;
+        }
+        data += written;
+        left -= (size_t)written;
+    }
+    bytesWritten += out.size() - left;
+}
+
+// TERMINAL SETUP
+// Raw mode (keys arrive one at a time, no echo) with the cursor hidden;
+// restored at exit, also after Ctrl+C
+static termios savedTerminal;
+static volatile sig_atomic_t terminalResized = 0;
+
+static void RestoreTerminal() {
+    const char* reset = "\x1b[0m\x1b[?25h";
+    write(STDOUT_FILENO, reset, strlen(reset));
+    tcsetattr(STDIN_FILENO, TCSAFLUSH, &savedTerminal);
+}
+
+static void HandleSignal(int signal) {
+    if (signal == SIGWINCH) {
+        terminalResized = 1;
+        return;
+    }
+    RestoreTerminal();
+    _exit(1);
+}
+
+static bool SetUpTerminal() {
+    if (!isatty(STDIN_FILENO) || tcgetattr(STDIN_FILENO, &savedTerminal) != 0) {
+        return false;
+    }
+    termios raw = savedTerminal;
+    raw.c_lflag &= ~(ICANON | ECHO);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw);
+    atexit(RestoreTerminal);
+    signal(SIGINT, HandleSignal);
+    signal(SIGTERM, HandleSignal);
+    signal(SIGWINCH, HandleSignal);
+    const char* hideCursor = "\x1b[?25l";
+    write(STDOUT_FILENO, hideCursor, strlen(hideCursor));
+    return true;
+}
+
+// Key codes besides plain characters
+const int KEY_NONE = -1;    // timed out
+const int KEY_REDRAW = -2;  // a signal (SIGWINCH) interrupted the wait
+const int KEY_UP = 256;
+const int KEY_DOWN = 257;
+const int KEY_LEFT = 258;
+const int KEY_RIGHT = 259;
+
+// Wait up to timeoutMs (-1 = forever) for a key. Arrow keys arrive as ESC [ A..D
+static int ReadKey(int timeoutMs) {
+    pollfd input = { STDIN_FILENO, POLLIN, 0 };
+    int ready = poll(&input, 1, timeoutMs);
+    if (ready < 0 && errno == EINTR) {
+        return KEY_REDRAW;  // not a timeout: no move is due yet
+    }
+    if (ready <= 0) {
+        return KEY_NONE;
+    }
+    unsigned char bytes[8];
+    ssize_t n = read(STDIN_FILENO, bytes, sizeof(bytes));
+    if (n <= 0) {
+        return 'q';  // input closed
+    }
+    if (n >= 3 && bytes[0] == 0x1b && bytes[1] == '[') {
+        switch (bytes[2]) {
+            case 'A': return KEY_UP;
+            case 'B': return KEY_DOWN;
+            case 'C': return KEY_RIGHT;
+            case 'D': return KEY_LEFT;
+        }
+        return 0x1b;  // another escape sequence: ignored, and not a timeout
+    }
+    return bytes[0];
+}
+
+// Direction for a key, or -1
+static int KeyDirection(int key) {
+    switch (key) {
+        case KEY_UP: case 'w': case 'W': return Grid::UP;
+        case KEY_DOWN: case 's': case 'S': return Grid::DOWN;
+        case KEY_LEFT: case 'a': case 'A': return Grid::LEFT;
+        case KEY_RIGHT: case 'd': case 'D': return Grid::RIGHT;
+    }
+    return -1;
+}
+
+// True if no move changes the board
+static bool IsGameOver(const Grid& grid) {
+    Board board;
+    if (!BoardFromGrid(grid, board)) {
+        return false;
+    }
+    for (int dir = 0; dir < 4; dir++) {
+        if (BoardMove(board, (Grid::Direction)dir) != board) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const char* replayPath = NULL;
+    int aiDepth = 0;
+    int speed = DEFAULT_SPEED;
+    Uint64 seed = (Uint64)time(NULL);
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--replay") == 0 && hasValue) {
+            replayPath = argv[++i];
+        } else if (strcmp(argv[i], "--ai") == 0) {
+            aiDepth = (hasValue && atoi(argv[i + 1]) > 0) ? atoi(argv[++i]) : 2;
+        } else if (strcmp(argv[i], "--speed") == 0 && hasValue) {
+            speed = std::clamp(atoi(argv[++i]), 1, MAX_SPEED);
+        } else if (strcmp(argv[i], "--seed") == 0 && hasValue) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "Usage: %s [--replay file | --ai [depth]] [--speed moves/s] [--seed n]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    // Load the replay before touching the terminal, so errors are readable
+    GameContext ctx;
+    Replay replay;
+    if (replayPath) {
+        std::string error;
+        if (!LoadReplay(replayPath, replay, &error)) {
+            fprintf(stderr, "Couldn't load replay: %s\n", error.c_str());
+            return 1;
+        }
+        if (replay.rows != GRID_ROWS || replay.cols != GRID_COLS) {
+            fprintf(stderr, "Couldn't load replay: recorded on a different grid size\n");
+            return 1;
+        }
+        seed = replay.seed;
+        ctx.high_score = replay.finalScore;
+    }
+    if (!SetUpTerminal()) {
+        fprintf(stderr, "%s needs a terminal\n", argv[0]);
+        return 1;
+    }
+
+    NewGame(ctx, seed);
+    Solver solver(1, 16);
+    bool watching = replayPath || aiDepth > 0;
+    bool paused = false;
+    size_t replayTurn = 0;
+    size_t illegalTurn = 0;  // the replay's first turn that doesn't apply (1-based), 0 = none
+    TtyRenderer renderer;
+    for (;;) {
+        // Status line for the current state
+        bool over = replayPath ? replayTurn == replay.turns.size() || illegalTurn > 0 : IsGameOver(ctx.grid);
+        std::string status;
+        if (illegalTurn > 0) {
+            status = "Replay stopped: turn " + std::to_string(illegalTurn) + " is illegal  (q quit)";
+        } else if (watching) {
+            char text[96];
+            snprintf(text, sizeof(text), "%s  %d moves/s  (space pause, +/- speed, q quit)",
+                     over ? "Game over" : paused ? "Paused" : replayPath ? "Replay" : "AI playing", speed);
+            status = text;
+        } else {
+            status = over ? "Game over  (r new game, q quit)" : "Arrows / WASD move, r restart, q quit";
+        }
+        if (terminalResized) {
+            terminalResized = 0;
+            renderer.invalidate();
+        }
+        renderer.draw(ctx, status);
+
+        // Wait for a key; when watching, only until the next move is due
+        int timeoutMs = (watching && !paused && !over) ? 1000 / speed : -1;
+        int key = ReadKey(timeoutMs);
+        if (key == 'q' || key == 'Q') {
+            break;
+        }
+        if (!watching) {
+            int dir = KeyDirection(key);
+            if (dir >= 0) {
+                PlayTurn(ctx, (Grid::Direction)dir);
+            } else if (key == 'r' || key == 'R') {
+                NewGame(ctx, (Uint64)time(NULL));
+            }
+            continue;
+        }
+
+        if (key == ' ') {
+            paused = !paused;
+        } else if (key == '+' || key == '=') {
+            speed = std::min(speed * 2, MAX_SPEED);
+        } else if (key == '-') {
+            speed = std::max(speed / 2, 1);
+        } else if (key == KEY_NONE && !paused && !over) {
+            // Next move of the replay, or the engine's choice
+            if (replayPath) {
+                if (ApplyRecordedTurn(ctx.grid, ctx.score, replay.turns[replayTurn])) {
+                    replayTurn++;
+                } else {
+                    illegalTurn = replayTurn + 1;  // stop here instead of showing a wrong board
+                }
+            } else {
+                Board board;
+                SearchLimits limits;
+                limits.depth = aiDepth;
+                if (BoardFromGrid(ctx.grid, board)) {
+                    SearchResult result = solver.search(board, limits);
+                    if (!result.moves.empty()) {
+                        PlayTurn(ctx, result.moves[0].dir);
+                    }
+                }
+            }
+        }
+    }
+
+    RestoreTerminal();
+    if (illegalTurn > 0) {
+        fprintf(stderr, "Replay %s has an illegal turn %zu\n", replayPath, illegalTurn);
+    }
+    printf("\n%llu frames, %llu bytes written (%.0f bytes per frame)\n",
+           (unsigned long long)renderer.getFrames(), (unsigned long long)renderer.getBytesWritten(),
+           renderer.getFrames() > 0 ? (double)renderer.getBytesWritten() / renderer.getFrames() : 0.0);
+    return 0;
+}
@@ -0,0 +1,105 @@
+// game2048-verify - checks replay files against the game rules
+//
+// Usage: game2048-verify [-j threads] <replay file or directory>...
+//
+// Every replay is re-played from its seed with the normal game rules and
+// random number generator (see VerifyReplay). Files are checked in parallel
+// on all cores; directories are searched recursively for *.rpl files.
+// Exits with 1 if any replay is illegal or does not reach its claimed score.
+#include "replay.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Result of checking one file
+struct VerifyResult {
+    bool ok = false;
+    int turns = 0;
+    int score = 0;
+    std::string error;
+};
+
+// Collect replay files from the command line, expanding directories
+static void CollectFiles(const char* arg, std::vector<std::string>& files) {
+    std::error_code ec;
+    if (!fs::is_directory(arg, ec)) {
+        files.push_back(arg);
+        return;
+    }
+    std::vector<std::string> found;
+    for (const fs::directory_entry& entry : fs::recursive_directory_iterator(arg, ec)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".rpl") {
+            found.push_back(entry.path().string());
+        }
+    }
+    std::sort(found.begin(), found.end());
+    files.insert(files.end(), found.begin(), found.end());
+}
+
+int main(int argc, char** argv) {
+    int threadCount = (int)std::thread::hardware_concurrency();
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threadCount = atoi(argv[++i]);
+        } else {
+            CollectFiles(argv[i], files);
+        }
+    }
+    if (files.empty()) {
+        fprintf(stderr, "Usage: %s [-j threads] <replay file or directory>...\n", argv[0]);
+        return 2;
+    }
+    threadCount = std::clamp(threadCount, 1, (int)files.size());
+
+    // Workers take the next unchecked file until none are left
+    std::vector<VerifyResult> results(files.size());
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t i = next++; i < files.size(); i = next++) {
+            VerifyResult& result = results[i];
+            Replay replay;
+            if (LoadReplay(files[i].c_str(), replay, &result.error)) {
+                result.turns = (int)replay.turns.size();
+                result.score = replay.finalScore;
+                result.ok = VerifyReplay(replay, &result.error);
+            }
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threadCount; i++) {
+        threads.emplace_back(worker);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Report in command line order so the output is stable
+    size_t failed = 0;
+    long long totalTurns = 0;
+    for (size_t i = 0; i < files.size(); i++) {
+        const VerifyResult& result = results[i];
+        totalTurns += result.turns;
+        if (result.ok) {
+            printf("OK    %s (%d turns, score %d)\n", files[i].c_str(), result.turns, result.score);
+        } else {
+            printf("FAIL  %s: %s\n", files[i].c_str(), result.error.c_str());
+            failed++;
+        }
+    }
+    printf("%zu replays, %zu failed, %lld turns in %.3f s on %d threads\n",
+           files.size(), failed, totalTurns, seconds, threadCount);
+    return failed == 0 ? 0 : 1;
+}
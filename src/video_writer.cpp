@@ -0,0 +1,145 @@
+#include "video_writer.h"
+#include "error.h"
+#include <cstring>
+
+static bool EndsWith(const char* text, const char* suffix) {
+    size_t textLength = strlen(text);
+    size_t suffixLength = strlen(suffix);
+    return textLength >= suffixLength && SDL_strcasecmp(text + textLength - suffixLength, suffix) == 0;
+}
+
+bool VideoWriter::open(const char* path, int frameWidth, int frameHeight, int fps, std::string* error) {
+    file = fopen(path, "wb");
+    if (!file) {
+        return Fail(error, std::string("can't open ") + path + " for writing");
+    }
+    y4m = EndsWith(path, ".y4m");
+    width = frameWidth;
+    height = frameHeight;
+    output.resize((size_t)width * height * 3);
+    for (std::vector<Uint32>& slot : slots) {
+        slot.resize((size_t)width * height);
+    }
+    head = 0;
+    count = 0;
+    closing = false;
+    failed = false;
+    framesWritten = 0;
+
+    if (y4m && fprintf(file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", width, height, fps) < 0) {
+        fclose(file);
+        file = nullptr;
+        return Fail(error, std::string("can't write ") + path);
+    }
+    thread = std::thread(&VideoWriter::run, this);
+    return true;
+}
+
+bool VideoWriter::addFrame(const void* pixels, int pitch) {
+    // Wait for a free buffer
+    int slot;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this]() { return count < QUEUE_FRAMES || failed; });
+        if (failed) {
+            return false;
+        }
+        slot = (head + count) % QUEUE_FRAMES;
+    }
+
+    // Copy row by row (the surface pitch may be wider than the frame)
+    Uint32* destination = slots[slot].data();
+    for (int y = 0; y < height; y++) {
+        memcpy(destination + (size_t)y * width, (const Uint8*)pixels + (size_t)y * pitch, (size_t)width * 4);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        count++;
+    }
+    changed.notify_all();
+    return true;
+}
+
+void VideoWriter::run() {
+    for (;;) {
+        int slot;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [this]() { return count > 0 || closing; });
+            if (count == 0) {
+                return;  // closing and everything is written
+            }
+            slot = head;
+        }
+
+        // Every Y4M frame starts with its own "FRAME" line
+        encode(slots[slot]);
+        bool ok = !y4m || fputs("FRAME\n", file) >= 0;
+        ok = ok && fwrite(output.data(), 1, output.size(), file) == output.size();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            head = (head + 1) % QUEUE_FRAMES;
+            count--;
+            if (ok) {
+                framesWritten++;
+            } else {
+                failed = true;
+                count = 0;  // drop the rest, the caller sees the failure
+            }
+        }
+        changed.notify_all();
+        if (!ok) {
+            return;
+        }
+    }
+}
+
+// Convert one XRGB8888 frame into output: planar Y, U, V for Y4M
+// (BT.601, studio range, like most decoders expect) or packed RGB
+void VideoWriter::encode(const std::vector<Uint32>& frame) {
+    size_t pixels = frame.size();
+    if (!y4m) {
+        for (size_t i = 0; i < pixels; i++) {
+            Uint32 p = frame[i];
+            output[i * 3 + 0] = (Uint8)(p >> 16);
+            output[i * 3 + 1] = (Uint8)(p >> 8);
+            output[i * 3 + 2] = (Uint8)p;
+        }
+        return;
+    }
+
+    Uint8* yPlane = output.data();
+    Uint8* uPlane = yPlane + pixels;
+    Uint8* vPlane = uPlane + pixels;
+    for (size_t i = 0; i < pixels; i++) {
+        Uint32 p = frame[i];
+        int r = (p >> 16) & 0xFF;
+        int g = (p >> 8) & 0xFF;
+        int b = p & 0xFF;
+        yPlane[i] = (Uint8)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        uPlane[i] = (Uint8)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+        vPlane[i] = (Uint8)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+    }
+}
+
+bool VideoWriter::close(std::string* error) {
+    if (!file) {
+        return true;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closing = true;
+    }
+    changed.notify_all();
+    thread.join();
+
+    bool ok = !failed;
+    ok = (fclose(file) == 0) && ok;
+    file = nullptr;
+    if (!ok) {
+        return Fail(error, "can't write the video file");
+    }
+    return true;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <SDL3/SDL_stdinc.h>
+#include <array>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// VideoWriter - streams rendered frames to a video file on its own thread
+// Files ending in .y4m are YUV4MPEG2 (4:4:4, readable by ffmpeg and most
+// players); anything else gets raw 24-bit RGB frames, one after another.
+// The caller renders the next frame while the writer converts and writes the
+// previous ones: frames pass through a bounded queue of QUEUE_FRAMES buffers,
+// so addFrame only blocks when the writer falls that far behind.
+class VideoWriter {
+public:
+    static const int QUEUE_FRAMES = 8;
+
+    // Create the file and start the writer thread. On failure return false
+    // and describe the problem in error (if given)
+    bool open(const char* path, int width, int height, int fps, std::string* error = nullptr);
+
+    // Queue one XRGB8888 frame of the size given to open (copied, so the
+    // caller can draw the next one right away). Returns false once a write failed
+    bool addFrame(const void* pixels, int pitch);
+
+    // Write the queued frames, stop the thread and close the file
+    bool close(std::string* error = nullptr);
+
+    bool isY4m() const { return y4m; }
+    int getFramesWritten() const { return framesWritten; }
+
+private:
+    void run();
+    void encode(const std::vector<Uint32>& frame);
+
+    FILE* file = nullptr;
+    bool y4m = false;
+    int width = 0;
+    int height = 0;
+    std::vector<Uint8> output;  // one converted frame, reused
+
+    // Ring of frame buffers: the caller fills slot (head + count) % QUEUE_FRAMES,
+    // the writer empties slot head. Each side only touches its own slot outside the lock
+    std::array<std::vector<Uint32>, QUEUE_FRAMES> slots;
+    int head = 0;
+    int count = 0;
+    bool closing = false;
+    bool failed = false;
+    int framesWritten = 0;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::thread thread;
+};